@@ -0,0 +1,100 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <chrono>      // std::chrono::steady_clock
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint64_t
+#include <cstdio>      // printf
+#include <limits>      // std::numeric_limits
+#include <string>      // std::string
+#include <string_view> // std::string_view
+
+namespace benchmarks {
+/// @return Number of bytes currently allocated with the global operator new.
+std::size_t allocated_bytes();
+
+/// @return Highest number of bytes allocated since the last reset.
+std::size_t peak_bytes();
+
+/// Reset the highest number of allocated bytes to the current number.
+void reset_peak_bytes();
+
+/// Only benchmarks whose name contains this string are run.
+inline std::string_view filter;
+
+/**
+ * Run a simulation until no more events are scheduled or the given number of
+ * steps is reached.
+ *
+ * @tparam Simulation Type of the simulation.
+ * @param sim Reference to the simulation.
+ * @param max_steps Maximum number of steps.
+ * @return Number of steps.
+ */
+template <typename Simulation>
+std::uint64_t run(Simulation &sim,
+                  std::uint64_t max_steps =
+                      std::numeric_limits<std::uint64_t>::max()) {
+  std::uint64_t n_steps = 0;
+  while (!sim.empty() && n_steps < max_steps) {
+    sim.step();
+    ++n_steps;
+  }
+
+  return n_steps;
+}
+
+/**
+ * Run one benchmark and print its results: the number of simulation steps,
+ * steps per second, nanoseconds per step and the peak number of bytes
+ * allocated on top of the allocations alive before the benchmark.
+ *
+ * @tparam F Type of the benchmark function.
+ * @param name Name of the benchmark.
+ * @param f Benchmark function. Sets up and runs a simulation and returns the
+ * number of simulation steps.
+ */
+template <typename F> void measure(const std::string &name, F &&f) {
+  if (name.find(filter) == std::string::npos) {
+    return;
+  }
+
+  reset_peak_bytes();
+  auto base_bytes = allocated_bytes();
+
+  auto start = std::chrono::steady_clock::now();
+  std::uint64_t n_steps = f();
+  auto end = std::chrono::steady_clock::now();
+
+  auto seconds = std::chrono::duration<double>(end - start).count();
+  auto n = static_cast<double>(n_steps);
+  auto peak_kib = static_cast<double>(peak_bytes() - base_bytes) / 1024;
+
+  printf("%-44s %10llu %12.0f %9.1f %11.0f\n", name.c_str(),
+         static_cast<unsigned long long>(n_steps), n / seconds,
+         seconds * 1e9 / n, peak_kib);
+}
+
+/// Benchmarks of processes awaiting timeouts with many pending events.
+void timeout_benchmarks();
+
+/// Benchmarks of processes starting and finishing.
+void process_benchmarks();
+
+/// Benchmarks of any_of and all_of.
+void condition_benchmarks();
+
+/// Benchmarks of passing values between processes.
+void value_event_benchmarks();
+
+/// Benchmarks of processes competing for a resource.
+void resource_benchmarks();
+
+/// Benchmarks of consumers blocked on a store fed by a single producer.
+void store_benchmarks();
+
+/// Benchmarks of sampling random variates.
+void random_benchmarks();
+} // namespace benchmarks
@@ -0,0 +1,64 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+// Fan-in: a process repeatedly awaits any_of or all_of of a number of
+// timeouts.
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <string>  // std::string, std::to_string
+#include <vector>  // std::vector
+
+#include "benchmark.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+namespace {
+template <bool All>
+simcpp20::event<> fan_in(simcpp20::simulation<> &sim, std::size_t n_children,
+                         std::uint64_t n_rounds) {
+  std::vector<simcpp20::event<>> evs;
+
+  for (std::uint64_t round = 0; round < n_rounds; ++round) {
+    evs.clear();
+    for (std::size_t i = 0; i < n_children; ++i) {
+      evs.push_back(sim.timeout(static_cast<double>(i % 7 + 1)));
+    }
+
+    if constexpr (All) {
+      co_await sim.all_of(evs);
+    } else {
+      co_await sim.any_of(evs);
+    }
+  }
+}
+
+simcpp20::event<> pairs(simcpp20::simulation<> &sim, std::uint64_t n_rounds) {
+  for (std::uint64_t round = 0; round < n_rounds; ++round) {
+    co_await (sim.timeout(1) & sim.timeout(2));
+    co_await (sim.timeout(1) | sim.timeout(2));
+  }
+}
+
+template <bool All> void fan_in_all(const std::string &name) {
+  for (std::size_t n_children : {2, 16, 256}) {
+    benchmarks::measure(name + "/" + std::to_string(n_children), [&] {
+      simcpp20::simulation<> sim;
+      fan_in<All>(sim, n_children, 1'000'000 / n_children);
+      return benchmarks::run(sim);
+    });
+  }
+}
+} // namespace
+
+namespace benchmarks {
+void condition_benchmarks() {
+  fan_in_all<true>("condition/all_of");
+  fan_in_all<false>("condition/any_of");
+
+  measure("condition/operators", [] {
+    simcpp20::simulation<> sim;
+    pairs(sim, 250'000);
+    return run(sim);
+  });
+}
+} // namespace benchmarks
@@ -0,0 +1,29 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+// Usage: benchmarks [filter]
+//
+// Runs all benchmarks whose name contains the filter and prints the number of
+// simulation steps, steps per second, nanoseconds per step and the peak number
+// of KiB allocated by each benchmark.
+
+#include <cstdio> // printf
+
+#include "benchmark.hpp"
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) {
+    benchmarks::filter = argv[1];
+  }
+
+  printf("%-44s %10s %12s %9s %11s\n", "benchmark", "steps", "steps/s",
+         "ns/step", "peak KiB");
+
+  benchmarks::timeout_benchmarks();
+  benchmarks::process_benchmarks();
+  benchmarks::condition_benchmarks();
+  benchmarks::value_event_benchmarks();
+  benchmarks::resource_benchmarks();
+  benchmarks::store_benchmarks();
+  benchmarks::random_benchmarks();
+}
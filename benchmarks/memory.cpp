@@ -0,0 +1,74 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+// Replaces the global operator new and delete to track the number of
+// allocated bytes. Each allocation is preceded by a header storing its size.
+
+#include <atomic>  // std::atomic
+#include <cstddef> // std::max_align_t, std::size_t
+#include <cstdlib> // std::free, std::malloc
+#include <new>     // std::bad_alloc
+
+#include "benchmark.hpp"
+
+namespace {
+constexpr std::size_t header_size = alignof(std::max_align_t);
+
+std::atomic<std::size_t> current_bytes{0};
+std::atomic<std::size_t> max_bytes{0};
+
+void *allocate(std::size_t size) {
+  auto ptr = static_cast<std::byte *>(std::malloc(size + header_size));
+  if (!ptr) {
+    throw std::bad_alloc{};
+  }
+
+  *reinterpret_cast<std::size_t *>(ptr) = size;
+  auto current = current_bytes.fetch_add(size, std::memory_order_relaxed);
+  current += size;
+
+  auto max = max_bytes.load(std::memory_order_relaxed);
+  while (current > max &&
+         !max_bytes.compare_exchange_weak(max, current,
+                                          std::memory_order_relaxed)) {
+  }
+
+  return ptr + header_size;
+}
+
+void deallocate(void *ptr) noexcept {
+  if (!ptr) {
+    return;
+  }
+
+  auto base = static_cast<std::byte *>(ptr) - header_size;
+  auto size = *reinterpret_cast<std::size_t *>(base);
+  current_bytes.fetch_sub(size, std::memory_order_relaxed);
+  std::free(base);
+}
+} // namespace
+
+void *operator new(std::size_t size) { return allocate(size); }
+
+void *operator new[](std::size_t size) { return allocate(size); }
+
+void operator delete(void *ptr) noexcept { deallocate(ptr); }
+
+void operator delete[](void *ptr) noexcept { deallocate(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { deallocate(ptr); }
+
+void operator delete[](void *ptr, std::size_t) noexcept { deallocate(ptr); }
+
+namespace benchmarks {
+std::size_t allocated_bytes() {
+  return current_bytes.load(std::memory_order_relaxed);
+}
+
+std::size_t peak_bytes() { return max_bytes.load(std::memory_order_relaxed); }
+
+void reset_peak_bytes() {
+  max_bytes.store(current_bytes.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+}
+} // namespace benchmarks
@@ -0,0 +1,148 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+// Churn of short-lived processes: a source process spawns processes which
+// finish after a few events. Also machines working in segments which are
+// rarely interrupted by failures, either waiting for (timeout | failure) in
+// each segment or being interrupted. Both run for the same simulated time, so
+// compare the number of steps times the time per step.
+
+#include <cstdint> // std::uint64_t
+#include <vector>  // std::vector
+
+#include "benchmark.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+namespace {
+simcpp20::event<> finish_immediately(simcpp20::simulation<> &) { co_return; }
+
+simcpp20::event<> finish_after_timeout(simcpp20::simulation<> &sim) {
+  co_await sim.timeout(1);
+}
+
+simcpp20::event<> await_child(simcpp20::simulation<> &sim, int depth) {
+  if (depth > 0) {
+    co_await await_child(sim, depth - 1);
+  }
+}
+
+template <typename Spawn>
+simcpp20::event<> source(simcpp20::simulation<> &sim, std::uint64_t n,
+                         Spawn spawn) {
+  for (std::uint64_t i = 0; i < n; ++i) {
+    spawn(sim);
+    if (i % 16 == 0) {
+      co_await sim.timeout(1);
+    }
+  }
+}
+
+template <typename Spawn> std::uint64_t churn(Spawn spawn) {
+  simcpp20::simulation<> sim;
+  source(sim, 1'000'000, spawn);
+  return benchmarks::run(sim);
+}
+
+/// Number of machines in the machine benchmarks.
+constexpr int n_machines = 1000;
+
+/// Time between two failures of a machine.
+constexpr double time_to_failure = 1000;
+
+/// Simulated time of the machine benchmarks.
+constexpr double machine_time = 10 * time_to_failure;
+
+simcpp20::event<> any_of_machine(simcpp20::simulation<> &sim,
+                                 simcpp20::event<> &failure) {
+  while (true) {
+    co_await (sim.timeout(1) | failure);
+    if (failure.triggered()) {
+      co_await sim.timeout(1);
+    }
+  }
+}
+
+simcpp20::event<> any_of_failures(simcpp20::simulation<> &sim,
+                                  simcpp20::event<> &failure) {
+  while (true) {
+    co_await sim.timeout(time_to_failure);
+    failure.trigger();
+    failure = sim.event();
+  }
+}
+
+simcpp20::event<> interrupted_machine(simcpp20::simulation<> &sim) {
+  while (true) {
+    bool failed = false;
+    try {
+      co_await sim.timeout(1);
+    } catch (const simcpp20::interrupted &) {
+      failed = true;
+    }
+
+    if (failed) {
+      co_await sim.timeout(1);
+    }
+  }
+}
+
+simcpp20::event<> interrupting_failures(simcpp20::simulation<> &sim,
+                                        simcpp20::event<> machine) {
+  while (true) {
+    co_await sim.timeout(time_to_failure);
+    machine.interrupt();
+  }
+}
+
+/**
+ * @param sim Reference to the simulation.
+ * @return Number of steps until the simulated time of the machine benchmarks
+ * is reached.
+ */
+std::uint64_t run_machines(simcpp20::simulation<> &sim) {
+  std::uint64_t n_steps = 0;
+  while (!sim.empty() && sim.next_time() < machine_time) {
+    sim.step();
+    ++n_steps;
+  }
+
+  return n_steps;
+}
+} // namespace
+
+namespace benchmarks {
+void process_benchmarks() {
+  measure("process/finish_immediately", [] {
+    return churn([](auto &sim) { finish_immediately(sim); });
+  });
+
+  measure("process/finish_after_timeout", [] {
+    return churn([](auto &sim) { finish_after_timeout(sim); });
+  });
+
+  measure("process/await_child/depth_8", [] {
+    return churn([](auto &sim) { await_child(sim, 8); });
+  });
+
+  measure("process/failures/any_of", [] {
+    simcpp20::simulation<> sim;
+    std::vector<simcpp20::event<>> failures(n_machines, sim.event());
+    for (auto &failure : failures) {
+      failure = sim.event();
+      any_of_machine(sim, failure);
+      any_of_failures(sim, failure);
+    }
+
+    return run_machines(sim);
+  });
+
+  measure("process/failures/interrupt", [] {
+    simcpp20::simulation<> sim;
+    for (int i = 0; i < n_machines; ++i) {
+      interrupting_failures(sim, interrupted_machine(sim));
+    }
+
+    return run_machines(sim);
+  });
+}
+} // namespace benchmarks
@@ -0,0 +1,81 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+// Sampling inter-arrival times: a shared standard library engine compared
+// with a random_stream. The variate benchmarks count one step per variate.
+
+#include <cstdint> // std::uint64_t
+#include <random>  // std::default_random_engine, std::exponential_distribution
+
+#include "benchmark.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+namespace {
+template <typename Sample>
+simcpp20::event<> arrivals(simcpp20::simulation<> &sim, std::uint64_t n,
+                           Sample sample) {
+  for (std::uint64_t i = 0; i < n; ++i) {
+    co_await sim.timeout(sample());
+  }
+}
+} // namespace
+
+namespace benchmarks {
+void random_benchmarks() {
+  constexpr std::uint64_t n = 10'000'000;
+  double sum = 0;
+
+  measure("random/exponential/std", [&] {
+    std::default_random_engine gen{42};
+    std::exponential_distribution<> dist{2};
+    for (std::uint64_t i = 0; i < n; ++i) {
+      sum += dist(gen);
+    }
+    return n;
+  });
+
+  measure("random/exponential/stream", [&] {
+    simcpp20::random_stream rng{42};
+    for (std::uint64_t i = 0; i < n; ++i) {
+      sum += rng.exponential(2);
+    }
+    return n;
+  });
+
+  measure("random/normal/std", [&] {
+    std::default_random_engine gen{42};
+    std::normal_distribution<> dist{10, 2};
+    for (std::uint64_t i = 0; i < n; ++i) {
+      sum += dist(gen);
+    }
+    return n;
+  });
+
+  measure("random/normal/stream", [&] {
+    simcpp20::random_stream rng{42};
+    for (std::uint64_t i = 0; i < n; ++i) {
+      sum += rng.normal(10, 2);
+    }
+    return n;
+  });
+
+  measure("random/arrivals/std", [&] {
+    simcpp20::simulation<> sim;
+    std::default_random_engine gen{42};
+    std::exponential_distribution<> dist{2};
+    arrivals(sim, 1'000'000, [&] { return dist(gen); });
+    return run(sim);
+  });
+
+  measure("random/arrivals/stream", [&] {
+    simcpp20::simulation<> sim;
+    simcpp20::random_stream rng{42};
+    arrivals(sim, 1'000'000, [&] { return rng.exponential(2); });
+    return run(sim);
+  });
+
+  if (sum == 0) {
+    printf("unexpected sum\n");
+  }
+}
+} // namespace benchmarks
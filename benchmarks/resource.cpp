@@ -0,0 +1,120 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+// Resource contention: customers arrive with exponentially distributed
+// interarrival times and request one of a number of servers.
+
+#include <cstdint> // std::uint64_t
+#include <random>  // std::exponential_distribution, std::mt19937_64
+#include <string>  // std::string, std::to_string
+
+#include "benchmark.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+namespace {
+simcpp20::event<> customer(simcpp20::simulation<> &sim,
+                           simcpp20::resource<> &servers,
+                           double service_time) {
+  co_await servers.request();
+  co_await sim.timeout(service_time);
+  servers.release();
+}
+
+simcpp20::event<> reneging_customer(simcpp20::simulation<> &sim,
+                                    simcpp20::resource<> &servers,
+                                    double service_time) {
+  auto req = servers.request();
+  if (co_await req.wait_for(1)) {
+    co_await sim.timeout(service_time);
+    servers.release();
+  }
+}
+
+simcpp20::event<> priority_customer(simcpp20::simulation<> &sim,
+                                    simcpp20::priority_resource<> &servers,
+                                    int priority, double service_time) {
+  co_await servers.request(priority);
+  co_await sim.timeout(service_time);
+  servers.release();
+}
+
+simcpp20::event<> preemptive_customer(simcpp20::simulation<> &sim,
+                                      simcpp20::preemptive_resource<> &servers,
+                                      int priority, double service_time) {
+  auto req = servers.request(priority);
+  co_await req;
+  co_await (sim.timeout(service_time) | servers.preempted(req));
+  servers.release(req);
+}
+
+/**
+ * Start customers with exponentially distributed interarrival times at a
+ * utilization of 95 %.
+ *
+ * @param start Called with the priority and the service time of each
+ * customer.
+ */
+template <typename Start>
+simcpp20::event<> customer_source(simcpp20::simulation<> &sim,
+                                  std::uint64_t n_servers,
+                                  std::uint64_t n_customers, Start start) {
+  std::mt19937_64 gen{42};
+  std::exponential_distribution<> arrival_dist{0.95 *
+                                               static_cast<double>(n_servers)};
+  std::exponential_distribution<> service_dist{1};
+  std::uniform_int_distribution<> priority_dist{0, 3};
+
+  for (std::uint64_t i = 0; i < n_customers; ++i) {
+    start(priority_dist(gen), service_dist(gen));
+    co_await sim.timeout(arrival_dist(gen));
+  }
+}
+} // namespace
+
+namespace benchmarks {
+void resource_benchmarks() {
+  constexpr std::uint64_t n_customers = 500'000;
+
+  for (std::uint64_t n_servers : {1, 64}) {
+    auto n = std::to_string(n_servers);
+
+    measure("resource/fifo/" + n, [&] {
+      simcpp20::simulation<> sim;
+      simcpp20::resource<> servers{sim, n_servers};
+      customer_source(sim, n_servers, n_customers, [&](int, double service) {
+        customer(sim, servers, service);
+      });
+      return run(sim);
+    });
+
+    measure("resource/renege/" + n, [&] {
+      simcpp20::simulation<> sim;
+      simcpp20::resource<> servers{sim, n_servers};
+      customer_source(sim, n_servers, n_customers, [&](int, double service) {
+        reneging_customer(sim, servers, service);
+      });
+      return run(sim);
+    });
+
+    measure("resource/priority/" + n, [&] {
+      simcpp20::simulation<> sim;
+      simcpp20::priority_resource<> servers{sim, n_servers};
+      customer_source(sim, n_servers, n_customers,
+                      [&](int priority, double service) {
+                        priority_customer(sim, servers, priority, service);
+                      });
+      return run(sim);
+    });
+
+    measure("resource/preemptive/" + n, [&] {
+      simcpp20::simulation<> sim;
+      simcpp20::preemptive_resource<> servers{sim, n_servers};
+      customer_source(sim, n_servers, n_customers,
+                      [&](int priority, double service) {
+                        preemptive_customer(sim, servers, priority, service);
+                      });
+      return run(sim);
+    });
+  }
+}
+} // namespace benchmarks
@@ -0,0 +1,78 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+// Store throughput: a single producer puts items into a store on which many
+// consumers are blocked, each waiting for the next item.
+
+#include <cstdint> // std::uint64_t
+#include <string>  // std::string, std::to_string
+
+#include "benchmark.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+namespace {
+simcpp20::event<> producer(simcpp20::simulation<> &sim,
+                           simcpp20::store<std::uint64_t> &store,
+                           std::uint64_t n_items) {
+  for (std::uint64_t i = 0; i < n_items; ++i) {
+    co_await store.put(i);
+    co_await sim.timeout(1);
+  }
+}
+
+simcpp20::event<> consumer(simcpp20::simulation<> &,
+                           simcpp20::store<std::uint64_t> &store,
+                           std::uint64_t n_items, std::uint64_t &n_taken) {
+  while (n_taken < n_items) {
+    co_await store.get();
+    ++n_taken;
+  }
+}
+
+simcpp20::event<> patient_consumer(simcpp20::simulation<> &,
+                                   simcpp20::store<std::uint64_t> &store,
+                                   double patience, std::uint64_t n_items,
+                                   std::uint64_t &n_taken) {
+  while (n_taken < n_items) {
+    auto get = store.get();
+    if (co_await get.wait_for(patience)) {
+      ++n_taken;
+    }
+  }
+}
+} // namespace
+
+namespace benchmarks {
+void store_benchmarks() {
+  constexpr std::uint64_t n_items = 500'000;
+
+  for (std::uint64_t n_consumers : {1, 1000, 10000}) {
+    auto n = std::to_string(n_consumers);
+
+    measure("store/get/" + n, [&] {
+      simcpp20::simulation<> sim;
+      simcpp20::store<std::uint64_t> store{sim};
+      std::uint64_t n_taken = 0;
+      for (std::uint64_t i = 0; i < n_consumers; ++i) {
+        consumer(sim, store, n_items, n_taken);
+      }
+      producer(sim, store, n_items);
+      return run(sim);
+    });
+
+    // Consumers give up after waiting for half of the items which are put
+    // while all of them wait, so about half of the gets time out.
+    measure("store/get_timed/" + n, [&] {
+      simcpp20::simulation<> sim;
+      simcpp20::store<std::uint64_t> store{sim};
+      std::uint64_t n_taken = 0;
+      auto patience = static_cast<double>(n_consumers) / 2;
+      for (std::uint64_t i = 0; i < n_consumers; ++i) {
+        patient_consumer(sim, store, patience, n_items, n_taken);
+      }
+      producer(sim, store, n_items);
+      return run(sim);
+    });
+  }
+}
+} // namespace benchmarks
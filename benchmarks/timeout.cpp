@@ -0,0 +1,166 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+// Hold model: a fixed number of processes repeatedly await a timeout with an
+// exponentially distributed delay, so the number of pending events stays
+// constant. In the race variant, each process awaits the first of two
+// timeouts and aborts the other one. The warm-up variants only schedule many
+// initial timeouts, one by one or in bulk, and report them as steps. Both
+// keep the created events. With integral time, the delays are in ticks with a
+// mean of 1000 ticks. The periodic variants compare clocks awaiting a new
+// timeout in each iteration with clocks awaiting a timer.
+
+#include <cstdint>     // std::uint64_t
+#include <random>      // std::exponential_distribution, std::mt19937_64
+#include <string>      // std::string, std::to_string
+#include <type_traits> // std::is_integral_v
+#include <vector>      // std::vector
+
+#include "benchmark.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+namespace {
+template <typename Simulation>
+typename Simulation::time_type draw_delay(std::mt19937_64 &gen) {
+  using time_type = typename Simulation::time_type;
+  std::exponential_distribution<> delay_dist{1};
+
+  if constexpr (std::is_integral_v<time_type>) {
+    return static_cast<time_type>(delay_dist(gen) * 1000);
+  } else {
+    return static_cast<time_type>(delay_dist(gen));
+  }
+}
+
+template <typename Simulation>
+simcpp20::basic_event<Simulation> holder(Simulation &sim,
+                                         std::mt19937_64 &gen) {
+  while (true) {
+    co_await sim.timeout(draw_delay<Simulation>(gen));
+  }
+}
+
+template <typename Simulation>
+simcpp20::basic_event<Simulation> racer(Simulation &sim, std::mt19937_64 &gen) {
+  while (true) {
+    auto a = sim.timeout(draw_delay<Simulation>(gen));
+    auto b = sim.timeout(draw_delay<Simulation>(gen));
+    co_await (a | b);
+    a.abort();
+    b.abort();
+  }
+}
+
+template <typename Simulation>
+void race(const std::string &queue_name, std::uint64_t n_processes) {
+  auto name = "timeout/race/" + queue_name + "/" + std::to_string(n_processes);
+  benchmarks::measure(name, [&] {
+    Simulation sim;
+    std::mt19937_64 gen{42};
+    for (std::uint64_t i = 0; i < n_processes; ++i) {
+      racer(sim, gen);
+    }
+
+    return benchmarks::run(sim, n_processes + 2'000'000);
+  });
+}
+
+template <typename Simulation>
+void hold(const std::string &queue_name, std::uint64_t n_processes) {
+  auto name = "timeout/hold/" + queue_name + "/" + std::to_string(n_processes);
+  benchmarks::measure(name, [&] {
+    Simulation sim;
+    std::mt19937_64 gen{42};
+    for (std::uint64_t i = 0; i < n_processes; ++i) {
+      holder(sim, gen);
+    }
+
+    return benchmarks::run(sim, n_processes + 2'000'000);
+  });
+}
+
+template <typename Simulation>
+void warm_up(const std::string &queue_name, std::uint64_t n_events, bool bulk) {
+  auto name = (bulk ? "timeout/bulk/" : "timeout/single/") + queue_name + "/" +
+              std::to_string(n_events);
+  benchmarks::measure(name, [&] {
+    Simulation sim;
+    std::mt19937_64 gen{42};
+
+    std::vector<typename Simulation::time_type> delays(n_events);
+    for (auto &delay : delays) {
+      delay = draw_delay<Simulation>(gen);
+    }
+
+    std::vector<typename Simulation::event_type> evs;
+    if (bulk) {
+      evs = sim.timeouts(delays);
+    } else {
+      evs.reserve(n_events);
+      for (auto delay : delays) {
+        evs.push_back(sim.timeout(delay));
+      }
+    }
+
+    return n_events;
+  });
+}
+
+simcpp20::event<> timeout_clock(simcpp20::simulation<> &sim, double period) {
+  while (true) {
+    co_await sim.timeout(period);
+  }
+}
+
+simcpp20::event<> timer_clock(simcpp20::simulation<> &sim, double period) {
+  auto ticker = sim.periodic(period);
+  while (true) {
+    co_await ticker;
+  }
+}
+
+template <typename Clock>
+void periodic(const std::string &variant, std::uint64_t n_clocks,
+              Clock clock) {
+  auto name = "timeout/periodic/" + variant + "/" + std::to_string(n_clocks);
+  benchmarks::measure(name, [&] {
+    simcpp20::simulation<> sim;
+    for (std::uint64_t i = 0; i < n_clocks; ++i) {
+      clock(sim, 1 + static_cast<double>(i % 10) / 10);
+    }
+
+    return benchmarks::run(sim, n_clocks + 2'000'000);
+  });
+}
+
+template <typename Simulation> void hold_all(const std::string &queue_name) {
+  for (std::uint64_t n_processes : {100, 10'000, 100'000}) {
+    hold<Simulation>(queue_name, n_processes);
+  }
+
+  race<Simulation>(queue_name, 10'000);
+
+  for (bool bulk : {false, true}) {
+    warm_up<Simulation>(queue_name, 1'000'000, bulk);
+  }
+}
+} // namespace
+
+namespace benchmarks {
+void timeout_benchmarks() {
+  hold_all<simcpp20::simulation<double, simcpp20::binary_heap>>("binary_heap");
+  hold_all<simcpp20::simulation<double, simcpp20::quaternary_heap>>(
+      "quaternary_heap");
+  hold_all<simcpp20::simulation<double, simcpp20::calendar_queue>>(
+      "calendar_queue");
+  hold_all<simcpp20::simulation<std::uint64_t, simcpp20::binary_heap>>(
+      "binary_heap_u64");
+  hold_all<simcpp20::simulation<std::uint64_t, simcpp20::radix_heap>>(
+      "radix_heap_u64");
+
+  for (std::uint64_t n_clocks : {100, 100'000}) {
+    periodic("timeout", n_clocks, timeout_clock);
+    periodic("timer", n_clocks, timer_clock);
+  }
+}
+} // namespace benchmarks
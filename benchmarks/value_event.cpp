@@ -0,0 +1,86 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+// Payload passing: a consumer repeatedly awaits a producer process returning
+// a value.
+
+#include <cstdint> // std::uint64_t
+#include <vector>  // std::vector
+
+#include "benchmark.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+namespace {
+simcpp20::value_event<int> produce_int(simcpp20::simulation<> &sim) {
+  co_await sim.timeout(1);
+  co_return 42;
+}
+
+simcpp20::value_event<std::vector<int>>
+produce_vector(simcpp20::simulation<> &sim) {
+  co_await sim.timeout(1);
+  co_return std::vector<int>(1000, 42);
+}
+
+simcpp20::event<> consume_int(simcpp20::simulation<> &sim, std::uint64_t n,
+                              std::uint64_t &sum) {
+  for (std::uint64_t i = 0; i < n; ++i) {
+    sum += co_await produce_int(sim);
+  }
+}
+
+template <bool Take>
+simcpp20::event<> consume_vector(simcpp20::simulation<> &sim, std::uint64_t n,
+                                 std::uint64_t &sum) {
+  for (std::uint64_t i = 0; i < n; ++i) {
+    if constexpr (Take) {
+      auto value = co_await produce_vector(sim).take();
+      sum += value.size();
+    } else {
+      auto value = co_await produce_vector(sim);
+      sum += value.size();
+    }
+  }
+}
+
+simcpp20::event<> timeout_values(simcpp20::simulation<> &sim, std::uint64_t n,
+                                 std::uint64_t &sum) {
+  for (std::uint64_t i = 0; i < n; ++i) {
+    sum += co_await sim.timeout<int>(1, 42);
+  }
+}
+} // namespace
+
+namespace benchmarks {
+void value_event_benchmarks() {
+  std::uint64_t sum = 0;
+
+  measure("value_event/timeout_int", [&] {
+    simcpp20::simulation<> sim;
+    timeout_values(sim, 1'000'000, sum);
+    return run(sim);
+  });
+
+  measure("value_event/process_int", [&] {
+    simcpp20::simulation<> sim;
+    consume_int(sim, 500'000, sum);
+    return run(sim);
+  });
+
+  measure("value_event/process_vector/copy", [&] {
+    simcpp20::simulation<> sim;
+    consume_vector<false>(sim, 200'000, sum);
+    return run(sim);
+  });
+
+  measure("value_event/process_vector/take", [&] {
+    simcpp20::simulation<> sim;
+    consume_vector<true>(sim, 200'000, sum);
+    return run(sim);
+  });
+
+  if (sum == 0) {
+    printf("unexpected sum\n");
+  }
+}
+} // namespace benchmarks
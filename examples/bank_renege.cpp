@@ -7,30 +7,33 @@
 #include <random>
 
 #include "fschuetz04/simcpp20.hpp"
-#include "resource.hpp"
 
 struct config {
   int n_customers;
-  resource counters;
+  simcpp20::resource<> counters;
   std::uniform_real_distribution<> max_wait_time_dist;
   std::exponential_distribution<> arrival_interval_dist;
   std::exponential_distribution<> service_time_dist;
   std::default_random_engine gen;
+  simcpp20::tally waits;
+  simcpp20::counter reneged;
 };
 
 simcpp20::event<> customer(simcpp20::simulation<> &sim, config &conf, int id) {
   printf("[%5.1f] Customer %d arrives\n", sim.now(), id);
 
+  auto arrival = sim.now();
   auto request = conf.counters.request();
   auto max_wait_time = conf.max_wait_time_dist(conf.gen);
-  co_await (request | sim.timeout(max_wait_time));
 
-  if (!request.triggered()) {
-    request.abort();
+  if (!co_await request.wait_for(max_wait_time)) {
     printf("[%5.1f] Customer %d RENEGES\n", sim.now(), id);
+    conf.reneged.add();
     co_return;
   }
 
+  conf.waits.add(sim.now() - arrival);
+
   printf("[%5.1f] Customer %d gets to the counter\n", sim.now(), id);
 
   co_await sim.timeout(conf.service_time_dist(conf.gen));
@@ -52,14 +55,21 @@ int main() {
   std::random_device rd;
   config conf{
       .n_customers = 5,
-      .counters = resource{sim, 1},
+      .counters = simcpp20::resource<>{sim, 1},
       .max_wait_time_dist = std::uniform_real_distribution<>{1., 3.},
       .arrival_interval_dist = std::exponential_distribution<>{1. / 10},
       .service_time_dist = std::exponential_distribution<>{1. / 12},
       .gen = std::default_random_engine{rd()},
+      .waits = simcpp20::tally{},
+      .reneged = simcpp20::counter{},
   };
 
   customer_source(sim, conf);
 
   sim.run();
+
+  printf("%llu customers reneged, %llu waited %.1f on average\n",
+         static_cast<unsigned long long>(conf.reneged.value()),
+         static_cast<unsigned long long>(conf.waits.count()),
+         conf.waits.mean());
 }
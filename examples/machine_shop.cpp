@@ -5,23 +5,24 @@
 
 #include <cstdio>
 #include <random>
+#include <vector>
 
 #include "fschuetz04/simcpp20.hpp"
-#include "resource.hpp"
 
 struct config {
   double repair_time;
-  resource repair_man;
-  std::normal_distribution<> time_for_part_dist;
-  std::exponential_distribution<> time_to_failure_dist;
-  std::default_random_engine gen;
+  double mean_time_for_part;
+  double sigma_time_for_part;
+  double mean_time_to_failure;
+  simcpp20::resource<> repair_man;
+  simcpp20::random_stream rng;
 };
 
 class machine {
 public:
-  machine(simcpp20::simulation<> &sim, config &conf)
-      : sim{sim}, conf{conf}, failure{sim.event()} {
-    produce();
+  machine(simcpp20::simulation<> &sim, config &conf, int id)
+      : sim{sim}, conf{conf}, rng{conf.rng.substream(id)},
+        process{produce()} {
     fail();
   }
 
@@ -31,38 +32,51 @@ public:
 private:
   simcpp20::event<> produce() {
     while (true) {
-      double time_for_part = conf.time_for_part_dist(conf.gen);
+      double time_for_part =
+          rng.normal(conf.mean_time_for_part, conf.sigma_time_for_part);
 
       while (true) {
         double start = sim.now();
         auto timeout = sim.timeout(time_for_part);
-        co_await (timeout | failure);
+        try {
+          co_await timeout;
+        } catch (const simcpp20::interrupted &) {
+          broken = true;
+        }
 
-        if (timeout.triggered()) {
+        if (!broken) {
           // part is finished
           ++n_parts_made;
           break;
         }
 
-        // machine failed, calculate remaining time for part and wait for repair
+        // machine failed, remove the timeout from the queue, calculate
+        // remaining time for part and wait for repair
+        timeout.abort();
         time_for_part -= sim.now() - start;
         co_await conf.repair_man.request();
         co_await sim.timeout(conf.repair_time);
         conf.repair_man.release();
+        broken = false;
       }
     }
   }
 
   simcpp20::event<> fail() {
     while (true) {
-      co_await sim.timeout(conf.time_to_failure_dist(conf.gen));
-      failure.trigger();
-      failure = sim.event();
+      co_await sim.timeout(rng.exponential(1 / conf.mean_time_to_failure));
+      if (!broken) {
+        process.interrupt();
+      }
     }
   }
 
   config &conf;
-  simcpp20::event<> failure;
+  // each machine draws from its own stream, so its parts and failures do not
+  // depend on the other machines
+  simcpp20::random_stream rng;
+  bool broken = false;
+  simcpp20::event<> process;
 };
 
 int main() {
@@ -71,17 +85,18 @@ int main() {
   std::random_device rd;
   config conf{
       .repair_time = 30,
-      .repair_man = resource{sim, 1},
-      .time_for_part_dist = std::normal_distribution<>{10, 2},
-      .time_to_failure_dist = std::exponential_distribution<>{1. / 300},
-      .gen = std::default_random_engine{rd()},
+      .mean_time_for_part = 10,
+      .sigma_time_for_part = 2,
+      .mean_time_to_failure = 300,
+      .repair_man = simcpp20::resource<>{sim, 1},
+      .rng = simcpp20::random_stream{rd()},
   };
 
   int n_machines = 10;
   std::vector<machine> machines;
   machines.reserve(n_machines);
   for (int i = 0; i < n_machines; ++i) {
-    machines.emplace_back(sim, conf);
+    machines.emplace_back(sim, conf, i);
   }
 
   int n_weeks = 4;
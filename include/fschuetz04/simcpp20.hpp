@@ -3,4 +3,17 @@
 
 #pragma once
 
+#include "simcpp20/calendar_queue.hpp"
+#include "simcpp20/injector.hpp"
+#include "simcpp20/monitor.hpp"
+#include "simcpp20/parallel_simulation.hpp"
+#include "simcpp20/preemptive_resource.hpp"
+#include "simcpp20/priority_resource.hpp"
+#include "simcpp20/radix_heap.hpp"
+#include "simcpp20/random.hpp"
+#include "simcpp20/realtime.hpp"
+#include "simcpp20/replications.hpp"
+#include "simcpp20/resource.hpp"
 #include "simcpp20/simulation.hpp"
+#include "simcpp20/store.hpp"
+#include "simcpp20/trace_reader.hpp"
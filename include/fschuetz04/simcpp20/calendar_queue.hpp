@@ -0,0 +1,298 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm> // std::partial_sort, std::sort, std::upper_bound
+#include <cassert>   // assert
+#include <cmath>     // std::floor, std::isfinite
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint64_t
+#include <iterator>  // std::make_move_iterator
+#include <limits>    // std::numeric_limits
+#include <utility>   // std::move
+#include <vector>    // std::erase_if, std::vector
+
+namespace simcpp20 {
+/**
+ * Queue of scheduled events implemented as a calendar queue (R. Brown, 1988).
+ *
+ * Items are hashed into buckets by their time. Each bucket covers an interval
+ * of fixed width, and the buckets are visited like the days of a year. The
+ * number of buckets follows the number of items, and the bucket width is
+ * re-estimated from the spacing of the earliest items whenever the buckets are
+ * resized, which gives O(1) amortized push and pop for stable distributions.
+ *
+ * The time of the items must be explicitly convertible to double and must not
+ * be negative, which holds for the simulation. Items are usually pushed at or
+ * after the time of the last popped item. The simulation may pop a discarded
+ * item scheduled after the current time, though, and then push items before
+ * it. Pushing such an item moves the current day back to its day.
+ *
+ * @tparam Item Type of the queued items.
+ */
+template <typename Item> class calendar_queue {
+public:
+  /// Constructor.
+  calendar_queue() : buckets_(min_buckets) {}
+
+  /// @return Whether the queue is empty.
+  bool empty() const { return size_ == 0; }
+
+  /// @return Number of queued items.
+  std::size_t size() const { return size_; }
+
+  /// @return First item of the queue.
+  const Item &top() const {
+    assert(!empty());
+    return buckets_[find()].back();
+  }
+
+  /// @param item Item to insert.
+  void push(Item item) {
+    // Searching or popping may have advanced the current day past the day of
+    // the item.
+    auto item_day = day(item);
+    if (item_day < day_) {
+      day_ = item_day;
+    }
+
+    insert(std::move(item));
+    ++size_;
+
+    if (size_ > 2 * buckets_.size()) {
+      resize(2 * buckets_.size());
+    }
+  }
+
+  /**
+   * Insert many items. If at least as many items are inserted as are queued,
+   * the buckets are rebuilt once for the new number of items instead of
+   * inserting each item and resizing repeatedly.
+   *
+   * @param items Items to insert.
+   */
+  void push_many(std::vector<Item> items) {
+    if (items.size() < size_) {
+      for (auto &item : items) {
+        push(std::move(item));
+      }
+      return;
+    }
+
+    auto all = take_items(items.size());
+    all.insert(all.end(), std::make_move_iterator(items.begin()),
+               std::make_move_iterator(items.end()));
+    size_ = all.size();
+
+    auto n_buckets = buckets_.size();
+    while (size_ > 2 * n_buckets) {
+      n_buckets *= 2;
+    }
+
+    rebuild(std::move(all), n_buckets);
+  }
+
+  /**
+   * Remove the first item of the queue.
+   *
+   * @return Removed item.
+   */
+  Item pop() {
+    assert(!empty());
+
+    auto &bucket = buckets_[find()];
+    auto item = std::move(bucket.back());
+    bucket.pop_back();
+    --size_;
+
+    if (size_ < buckets_.size() / 2 && buckets_.size() > min_buckets) {
+      resize(buckets_.size() / 2);
+    }
+
+    return item;
+  }
+
+  /**
+   * Remove all items matching a predicate in O(n).
+   *
+   * @tparam Predicate Type of the predicate.
+   * @param pred Predicate called with each item.
+   * @return Number of removed items.
+   */
+  template <typename Predicate> std::size_t erase_if(Predicate pred) {
+    std::size_t n = 0;
+    for (auto &bucket : buckets_) {
+      n += std::erase_if(bucket, pred);
+    }
+    size_ -= n;
+
+    auto n_buckets = buckets_.size();
+    while (size_ < n_buckets / 2 && n_buckets > min_buckets) {
+      n_buckets /= 2;
+    }
+
+    if (n_buckets != buckets_.size()) {
+      resize(n_buckets);
+    }
+
+    return n;
+  }
+
+private:
+  /**
+   * @param a Item.
+   * @param b Other item.
+   * @return Whether the item is ordered after the other item.
+   */
+  static bool after(const Item &a, const Item &b) { return a > b; }
+
+  /**
+   * @param item Item.
+   * @return Index of the interval of the bucket width containing the time of
+   * the item, counted from time zero. Days after max_day, for example of
+   * infinite times, are clamped to it, since they cannot be converted to the
+   * day type. Items on that day are still ordered within their bucket.
+   */
+  std::uint64_t day(const Item &item) const {
+    auto d = std::floor(static_cast<double>(item.time_) / width_);
+    if (!(d < static_cast<double>(max_day))) {
+      return max_day;
+    }
+
+    return static_cast<std::uint64_t>(d);
+  }
+
+  /**
+   * Insert an item into its bucket. Buckets are sorted in descending order,
+   * so that the first item of a bucket is at its back.
+   *
+   * @param item Item to insert.
+   */
+  void insert(Item item) {
+    auto &bucket = buckets_[day(item) % buckets_.size()];
+    auto pos = std::upper_bound(bucket.begin(), bucket.end(), item, after);
+    bucket.insert(pos, std::move(item));
+  }
+
+  /**
+   * Advance the current day to the day of the first item.
+   *
+   * @return Index of the bucket containing the first item.
+   */
+  std::size_t find() const {
+    auto n = buckets_.size();
+
+    for (std::size_t i = 0; i < n; ++i, ++day_) {
+      auto &bucket = buckets_[day_ % n];
+      if (!bucket.empty() && day(bucket.back()) == day_) {
+        return day_ % n;
+      }
+    }
+
+    // No item within the next year, search all buckets directly.
+    std::size_t min = n;
+    for (std::size_t i = 0; i < n; ++i) {
+      if (buckets_[i].empty()) {
+        continue;
+      }
+
+      if (min == n || buckets_[min].back() > buckets_[i].back()) {
+        min = i;
+      }
+    }
+
+    assert(min < n);
+    day_ = day(buckets_[min].back());
+    return min;
+  }
+
+  /**
+   * Rehash all items into a new number of buckets.
+   *
+   * @param n Number of buckets.
+   */
+  void resize(std::size_t n) { rebuild(take_items(0), n); }
+
+  /**
+   * Move all items out of the buckets.
+   *
+   * @param n_extra Number of items to reserve space for in addition.
+   * @return Items in no particular order.
+   */
+  std::vector<Item> take_items(std::size_t n_extra) {
+    std::vector<Item> items;
+    items.reserve(size_ + n_extra);
+    for (auto &bucket : buckets_) {
+      for (auto &item : bucket) {
+        items.push_back(std::move(item));
+      }
+      bucket.clear();
+    }
+
+    return items;
+  }
+
+  /**
+   * Hash items into a new number of buckets, estimating a new bucket width
+   * from the average spacing of the earliest items.
+   *
+   * @param items Items, which must be all queued items.
+   * @param n Number of buckets.
+   */
+  void rebuild(std::vector<Item> items, std::size_t n) {
+    auto n_sample = items.size() < sample_size ? items.size() : sample_size;
+    std::partial_sort(items.begin(), items.begin() + n_sample, items.end(),
+                      [](const Item &a, const Item &b) { return b > a; });
+
+    if (n_sample > 1) {
+      auto first = static_cast<double>(items.front().time_);
+      auto last = static_cast<double>(items[n_sample - 1].time_);
+      auto width = 3 * (last - first) / static_cast<double>(n_sample - 1);
+      if (width > 0 && std::isfinite(width)) {
+        width_ = width;
+      }
+    }
+
+    auto first_day = items.empty() ? day_ : day(items.front());
+
+    buckets_.clear();
+    buckets_.resize(n);
+    for (auto &item : items) {
+      buckets_[day(item) % n].push_back(std::move(item));
+    }
+
+    for (auto &bucket : buckets_) {
+      std::sort(bucket.begin(), bucket.end(), after);
+    }
+
+    day_ = first_day;
+  }
+
+  /// Minimum number of buckets.
+  static constexpr std::size_t min_buckets = 16;
+
+  /// Number of earliest items used to estimate the bucket width.
+  static constexpr std::size_t sample_size = 32;
+
+  /**
+   * Last day. A power of two, so that it is exactly representable as double,
+   * and far enough from the maximum of the day type that advancing the
+   * current day past it does not overflow.
+   */
+  static constexpr std::uint64_t max_day =
+      std::uint64_t{1} << (std::numeric_limits<std::uint64_t>::digits - 1);
+
+  /// Buckets, each sorted in descending order.
+  std::vector<std::vector<Item>> buckets_;
+
+  /// Number of queued items.
+  std::size_t size_ = 0;
+
+  /// Width of the interval covered by one bucket.
+  double width_ = 1;
+
+  /// Current day. No queued item has an earlier day.
+  mutable std::uint64_t day_ = 0;
+};
+} // namespace simcpp20
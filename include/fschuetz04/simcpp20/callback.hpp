@@ -0,0 +1,222 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert>     // assert
+#include <cstddef>     // std::byte, std::size_t
+#include <memory>      // std::allocator, std::allocator_arg,
+                       // std::allocator_arg_t, std::allocator_traits
+#include <new>         // ::new
+#include <type_traits> // std::decay_t, std::is_nothrow_move_constructible_v
+#include <utility>     // std::exchange, std::forward, std::move
+
+namespace simcpp20 {
+template <typename Signature> class callback;
+
+/**
+ * Move-only type-erased callable. Callables which fit into the inline buffer
+ * and can be moved without throwing are stored inline, larger ones in storage
+ * obtained from an allocator.
+ *
+ * @tparam Args Types of the arguments of the callable.
+ */
+template <typename... Args> class callback<void(Args...)> {
+public:
+  /**
+   * Constructor. Callables which do not fit inline are allocated with
+   * std::allocator.
+   *
+   * @tparam F Type of the callable.
+   * @param f Callable.
+   */
+  template <typename F>
+    requires(!std::is_same_v<std::decay_t<F>, callback>)
+  callback(F &&f)
+      : callback{std::allocator_arg, std::allocator<std::byte>{},
+                 std::forward<F>(f)} {}
+
+  /**
+   * Constructor.
+   *
+   * @tparam Allocator Type of the allocator, rebound to the callable type.
+   * @tparam F Type of the callable.
+   * @param alloc Allocator used if the callable does not fit inline.
+   * @param f Callable.
+   */
+  template <typename Allocator, typename F>
+  callback(std::allocator_arg_t, const Allocator &alloc, F &&f)
+      : ops_{&ops_for<std::decay_t<F>, rebind<Allocator, std::decay_t<F>>>} {
+    using stored = std::decay_t<F>;
+
+    if constexpr (fits_inline<stored>()) {
+      ::new (buffer_) stored(std::forward<F>(f));
+    } else {
+      using alloc_type = rebind<Allocator, stored>;
+      using traits = std::allocator_traits<alloc_type>;
+      using holder = allocated<stored, alloc_type>;
+      static_assert(sizeof(holder) <= buffer_size &&
+                    alignof(holder) <= alignof(void *));
+
+      alloc_type stored_alloc{alloc};
+      auto ptr = traits::allocate(stored_alloc, 1);
+      try {
+        traits::construct(stored_alloc, ptr, std::forward<F>(f));
+      } catch (...) {
+        traits::deallocate(stored_alloc, ptr, 1);
+        throw;
+      }
+
+      ::new (buffer_) holder{ptr, std::move(stored_alloc)};
+    }
+  }
+
+  /// Destructor.
+  ~callback() {
+    if (ops_) {
+      ops_->destroy(buffer_);
+    }
+  }
+
+  /**
+   * Move constructor.
+   *
+   * @param other Callback to move.
+   */
+  callback(callback &&other) noexcept : ops_{std::exchange(other.ops_, {})} {
+    if (ops_) {
+      ops_->move(buffer_, other.buffer_);
+    }
+  }
+
+  /**
+   * Move assignment operator.
+   *
+   * @param other Callback to replace this callback with.
+   * @return Reference to this instance.
+   */
+  callback &operator=(callback &&other) noexcept {
+    if (this != &other) {
+      if (ops_) {
+        ops_->destroy(buffer_);
+      }
+
+      ops_ = std::exchange(other.ops_, {});
+      if (ops_) {
+        ops_->move(buffer_, other.buffer_);
+      }
+    }
+
+    return *this;
+  }
+
+  callback(const callback &) = delete;
+  callback &operator=(const callback &) = delete;
+
+  /**
+   * Call the callable.
+   *
+   * @param args Arguments to call the callable with.
+   */
+  void operator()(Args... args) {
+    assert(ops_);
+    ops_->call(buffer_, std::forward<Args>(args)...);
+  }
+
+  /// Size of the inline buffer in bytes.
+  static constexpr std::size_t buffer_size = 4 * sizeof(void *);
+
+private:
+  /**
+   * @tparam Allocator Type of an allocator.
+   * @tparam T Type of the allocated objects.
+   */
+  template <typename Allocator, typename T>
+  using rebind =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+  /**
+   * Callable stored outside of the inline buffer, together with the allocator
+   * of its storage. Stored in the inline buffer.
+   *
+   * @tparam F Type of the callable.
+   * @tparam Alloc Type of the allocator of the callable.
+   */
+  template <typename F, typename Alloc> struct allocated {
+    /// Pointer to the callable.
+    F *ptr_;
+
+    /// Allocator of the callable.
+    [[no_unique_address]] Alloc alloc_;
+  };
+
+  /// Operations on one type of callable, shared by all instances.
+  struct ops {
+    /// Call the callable stored in the buffer.
+    void (*call)(std::byte *buffer, Args... args);
+
+    /// Move the callable from one buffer to another, destroying the source.
+    void (*move)(std::byte *dst, std::byte *src) noexcept;
+
+    /// Destroy the callable stored in the buffer.
+    void (*destroy)(std::byte *buffer) noexcept;
+  };
+
+  /**
+   * @tparam F Type of the callable.
+   * @return Whether the callable is stored inline.
+   */
+  template <typename F> static constexpr bool fits_inline() {
+    return sizeof(F) <= buffer_size && alignof(F) <= alignof(void *) &&
+           std::is_nothrow_move_constructible_v<F>;
+  }
+
+  /**
+   * @tparam F Type of the callable.
+   * @tparam Alloc Type of the allocator of the callable.
+   * @param buffer Buffer storing the callable.
+   * @return Reference to the stored callable.
+   */
+  template <typename F, typename Alloc> static F &get(std::byte *buffer) {
+    if constexpr (fits_inline<F>()) {
+      return *reinterpret_cast<F *>(buffer);
+    } else {
+      return *reinterpret_cast<allocated<F, Alloc> *>(buffer)->ptr_;
+    }
+  }
+
+  /// Operations for the callable type F allocated with Alloc.
+  template <typename F, typename Alloc>
+  static constexpr ops ops_for = {
+      [](std::byte *buffer, Args... args) {
+        get<F, Alloc>(buffer)(std::forward<Args>(args)...);
+      },
+      [](std::byte *dst, std::byte *src) noexcept {
+        if constexpr (fits_inline<F>()) {
+          ::new (dst) F(std::move(get<F, Alloc>(src)));
+          get<F, Alloc>(src).~F();
+        } else {
+          auto &other = *reinterpret_cast<allocated<F, Alloc> *>(src);
+          ::new (dst) allocated<F, Alloc>{other.ptr_, std::move(other.alloc_)};
+          other.~allocated();
+        }
+      },
+      [](std::byte *buffer) noexcept {
+        if constexpr (fits_inline<F>()) {
+          get<F, Alloc>(buffer).~F();
+        } else {
+          using traits = std::allocator_traits<Alloc>;
+          auto &held = *reinterpret_cast<allocated<F, Alloc> *>(buffer);
+          traits::destroy(held.alloc_, held.ptr_);
+          traits::deallocate(held.alloc_, held.ptr_, 1);
+          held.~allocated();
+        }
+      }};
+
+  /// Operations for the stored callable, or null if moved from.
+  const ops *ops_;
+
+  /// Buffer storing the callable or a pointer to it and its allocator.
+  alignas(void *) std::byte buffer_[buffer_size];
+};
+} // namespace simcpp20
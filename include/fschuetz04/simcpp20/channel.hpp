@@ -0,0 +1,175 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert> // assert
+#include <deque>   // std::deque
+#include <utility> // std::move
+#include <vector>  // std::vector
+
+#include "simulation.hpp"
+#include "value_event.hpp"
+
+namespace simcpp20 {
+/**
+ * Channel of a parallel simulation, independent of the value type.
+ *
+ * @tparam Time Type used for simulation time.
+ */
+template <typename Time> class basic_channel {
+public:
+  /// Destructor.
+  virtual ~basic_channel() = default;
+
+  /// @return Smallest delay between sending and receiving a message.
+  Time lookahead() const { return lookahead_; }
+
+protected:
+  /**
+   * Constructor.
+   *
+   * @param lookahead Smallest delay between sending and receiving a message.
+   */
+  explicit basic_channel(Time lookahead) : lookahead_{lookahead} {}
+
+  /**
+   * Schedule the messages sent since the last call in the receiving
+   * simulation. Called by the parallel simulation while no simulation runs.
+   */
+  virtual void deliver() = 0;
+
+private:
+  /// Smallest delay between sending and receiving a message.
+  Time lookahead_;
+
+  template <typename> friend class parallel_simulation;
+};
+
+/**
+ * Timestamped channel from one simulation of a parallel simulation to
+ * another. Messages are received in the order of their timestamps, and
+ * messages with equal timestamps in the order they were sent.
+ *
+ * send may only be called from processes of the sending simulation, and
+ * receive only from processes of the receiving simulation.
+ *
+ * @tparam Value Type of the messages.
+ * @tparam Time Type used for simulation time.
+ */
+template <typename Value, typename Time = double>
+class channel : public basic_channel<Time> {
+public:
+  /**
+   * Send a message which is received after the lookahead.
+   *
+   * @param value Message.
+   */
+  void send(Value value) { send(std::move(value), this->lookahead()); }
+
+  /**
+   * Send a message.
+   *
+   * @param value Message.
+   * @param delay Delay after which the message is received. Must not be less
+   * than the lookahead.
+   */
+  void send(Value value, Time delay) {
+    assert(delay >= this->lookahead());
+    outbox_.emplace_back(src_.now() + delay, std::move(value));
+  }
+
+  /**
+   * Receive the next message. If no message has arrived yet, the returned
+   * event is triggered with the next arriving message. Aborting the returned
+   * event before it is triggered cancels the receive.
+   *
+   * @return Value event which is triggered with the message.
+   */
+  value_event<Value, Time> receive() {
+    auto ev = dst_.template event<Value>();
+
+    if (inbox_.empty()) {
+      receivers_.push_back(ev);
+    } else {
+      ev.trigger(std::move(inbox_.front()));
+      inbox_.pop_front();
+    }
+
+    return ev;
+  }
+
+protected:
+  /// @see basic_channel::deliver
+  void deliver() override {
+    for (auto &message : outbox_) {
+      auto ev = dst_.event();
+      ev.add_callback([this, value = std::move(message.value_)](
+                          const auto &) mutable { arrive(std::move(value)); });
+      dst_.schedule_at(ev, message.time_);
+    }
+
+    outbox_.clear();
+  }
+
+private:
+  /**
+   * Constructor. Channels are created by parallel_simulation::connect.
+   *
+   * @param src Sending simulation.
+   * @param dst Receiving simulation.
+   * @param lookahead Smallest delay between sending and receiving a message.
+   * Must be positive.
+   */
+  channel(simulation<Time> &src, simulation<Time> &dst, Time lookahead)
+      : basic_channel<Time>{lookahead}, src_{src}, dst_{dst} {
+    assert(lookahead > Time{0});
+  }
+
+  /// Message which was sent, but not yet delivered.
+  struct message {
+    /// Time at which the message arrives.
+    Time time_;
+
+    /// Message.
+    Value value_;
+  };
+
+  /**
+   * Pass an arriving message to the first waiting receiver, or keep it until
+   * the next receive.
+   *
+   * @param value Message.
+   */
+  void arrive(Value value) {
+    while (!receivers_.empty()) {
+      auto ev = receivers_.front();
+      receivers_.pop_front();
+
+      if (ev.pending()) {
+        ev.trigger(std::move(value));
+        return;
+      }
+    }
+
+    inbox_.push_back(std::move(value));
+  }
+
+  /// Sending simulation.
+  simulation<Time> &src_;
+
+  /// Receiving simulation.
+  simulation<Time> &dst_;
+
+  /// Messages sent since the last delivery. Only used by the sender.
+  std::vector<message> outbox_;
+
+  /// Messages which arrived before a receive. Only used by the receiver.
+  std::deque<Value> inbox_;
+
+  /// Receives waiting for a message. Only used by the receiver.
+  std::deque<value_event<Value, Time>> receivers_;
+
+  template <typename> friend class parallel_simulation;
+};
+} // namespace simcpp20
@@ -3,48 +3,89 @@
 
 #pragma once
 
+#include <any>        // std::any
 #include <cassert>    // assert
 #include <cmath>      // std::log2
-#include <coroutine>  // std::coroutine_handle, std::suspend_never
-#include <cstddef>    // std::size_t
-#include <functional> // std::function, std::hash
-#include <memory>     // std::shared_ptr, std::make_shared
-#include <utility>    // std::exchange, std::move
-#include <vector>     // std::vector
+#include <coroutine>  // std::coroutine_handle, std::noop_coroutine
+#include <cstddef>    // std::byte, std::size_t
+#include <cstdint>    // std::uint64_t
+#include <functional> // std::hash
+#include <limits>     // std::numeric_limits
+#include <memory>     // std::allocator_arg
+#include <new>        // ::new
+#include <optional>   // std::optional
+#include <utility>    // std::exchange, std::forward, std::move
+
+#include "callback.hpp"
+#include "interrupted.hpp"
+#include "observer.hpp"
+#include "pool.hpp"
+#include "radix_heap.hpp"
+#include "small_vector.hpp"
+
+// The frames of processes are allocated by the templated operator new of the
+// promise types and freed by their usual operator delete. GCC 11 and later
+// report this as a mismatch unless operator new is inlined, also without
+// optimization.
+#if defined(__GNUC__)
+#define FSCHUETZ04_SIMCPP20_ALWAYS_INLINE [[gnu::always_inline]]
+#else
+#define FSCHUETZ04_SIMCPP20_ALWAYS_INLINE
+#endif
 
 namespace simcpp20 {
-template <typename Time> class simulation;
+template <typename Time = double,
+          template <typename> class Queue = default_queue,
+          typename Observer = no_observer>
+class simulation;
 
 /**
  * One event.
  *
- * @tparam Time Type used for simulation time.
+ * Events are handles to shared state, which is reference counted. A
+ * simulation is only driven by one thread at a time, so the reference count
+ * is a plain integer stored in the shared state instead of an atomic one.
+ * Handles of one simulation must not be copied or destroyed by multiple
+ * threads concurrently.
+ *
+ * Neither events nor their shared state or promises have virtual functions,
+ * so a handle is a single pointer. Shared state of derived event types is
+ * destroyed through a function pointer stored in the state.
+ *
+ * @tparam Simulation Type of the simulation the event belongs to.
  */
-template <typename Time = double> class event {
+template <typename Simulation> class basic_event {
 public:
   /**
    * Constructor.
    *
    * @param simulation Reference to the simulation.
    */
-  explicit event(simulation<Time> &sim) : data_{std::make_shared<data>(sim)} {}
+  explicit basic_event(Simulation &sim)
+      : data_{::new (sim.pool_.allocate(sizeof(data), memory_kind::events))
+                  data{sim}} {}
 
   /// Destructor.
-  virtual ~event() {}
+  ~basic_event() { release(); }
 
   /**
    * Copy constructor.
    *
    * @param other Event to copy.
    */
-  event(const event &other) : data_{other.data_} { assert(data_); }
+  basic_event(const basic_event &other) : data_{other.data_} {
+    assert(data_);
+    ++data_->ref_count_;
+  }
 
   /**
-   * Move constructor.
+   * Move constructor. The moved-from event may only be destroyed or assigned
+   * to.
    *
    * @param other Event to move.
    */
-  event(event &&other) noexcept : data_{std::move(other.data_)} {
+  basic_event(basic_event &&other) noexcept
+      : data_{std::exchange(other.data_, nullptr)} {
     assert(data_);
   }
 
@@ -54,20 +95,27 @@ public:
    * @param other Event to replace this event with.
    * @return Reference to this instance.
    */
-  event &operator=(const event &other) {
+  basic_event &operator=(const basic_event &other) {
+    assert(other.data_);
+    ++other.data_->ref_count_;
+    release();
     data_ = other.data_;
-    assert(data_);
     return *this;
   }
 
   /**
-   * Move assignment operator.
+   * Move assignment operator. The moved-from event may only be destroyed or
+   * assigned to.
    *
    * @param other Event to replace this event with.
    * @return Reference to this instance.
    */
-  event &operator=(event &&other) noexcept {
-    data_ = std::move(other.data_);
+  basic_event &operator=(basic_event &&other) noexcept {
+    if (this != &other) {
+      release();
+      data_ = std::exchange(other.data_, nullptr);
+    }
+
     assert(data_);
     return *this;
   }
@@ -91,7 +139,8 @@ public:
 
   /**
    * Set the event state to aborted. If the event is not pending, nothing is
-   * done.
+   * done. If the event is scheduled, for example a timeout, it is removed from
+   * the queue of the simulation.
    *
    * TODO(fschuetz04): Check whether used on a process? Destroy process
    * coroutine?
@@ -105,24 +154,64 @@ public:
 
     data_->state_ = state::aborted;
 
+    if (data_->queue_id_ != data::unqueued) {
+      data_->sim_.unqueue(*this);
+    }
+
     data_->cbs_.clear();
 
-    std::vector<generic_promise_type *> temp_promises;
-    data_->promises_.swap(temp_promises);
+    auto temp_promises = std::move(data_->promises_);
     for (auto &promise : temp_promises) {
       promise->process_handle().destroy();
     }
   }
 
-  /// @param cb Callback to be called when the event is processed.
-  void add_callback(std::function<void(const event<Time> &)> cb) const {
+  /**
+   * Interrupt the process associated with this event. The interrupt is thrown
+   * as simcpp20::interrupted by the co_await expression the process is
+   * suspended in, after the process is resumed at the current simulation time
+   * in the order of scheduling. The process stops waiting for the awaited
+   * event or resource request, which is not aborted. If the process is not
+   * suspended in such a co_await expression, for example because it is not
+   * started yet or already about to be resumed, the interrupt is thrown when
+   * the process suspends the next time. A process about to be resumed
+   * completes its co_await expression normally, whether it is resumed by an
+   * event or an awaitable, so a granted resource request or a received item
+   * is not lost. A process has at most one undelivered interrupt, whose cause
+   * is replaced by later interrupts. If the process finished, nothing is done.
+   *
+   * The event must be the event associated with a process, that is the event
+   * returned by a coroutine.
+   *
+   * @param cause Cause of the interrupt, available through
+   * simcpp20::interrupted::cause.
+   */
+  void interrupt(std::any cause = {}) const {
+    assert(data_);
+
+    if (!pending()) {
+      return;
+    }
+
+    assert(data_->process_);
+    data_->process_->interrupt(std::move(cause));
+  }
+
+  /**
+   * @tparam Callback Type of the callback.
+   * @param cb Callback to be called when the event is processed.
+   */
+  template <typename Callback> void add_callback(Callback &&cb) const {
     assert(data_);
 
     if (processed() || aborted()) {
       return;
     }
 
-    data_->cbs_.emplace_back(cb);
+    data_->cbs_.emplace_back(
+        std::allocator_arg,
+        pool_allocator<std::byte, memory_kind::callbacks>{data_->sim_.pool_},
+        std::forward<Callback>(cb));
   }
 
   /// @return Whether the event is pending.
@@ -175,14 +264,20 @@ public:
       return;
     }
 
-    data_->promises_.push_back(&handle.promise());
+    auto &promise = handle.promise();
+    data_->promises_.push_back(&promise);
+    promise.wait(data_, &cancel_wait);
   }
 
   /**
    * Called when a coroutine is resumed after using co_await on the event or if
-   * the coroutine did not need to be suspended.
+   * the coroutine did not need to be suspended. Throws simcpp20::interrupted
+   * if the coroutine was resumed because it was interrupted.
    */
-  void await_resume() { assert(data_); }
+  void await_resume() {
+    assert(data_);
+    data_->sim_.check_interrupt();
+  }
 
   /**
    * Alias for simulation::any_of.
@@ -191,7 +286,7 @@ public:
    * @return New pending event which is triggered when this event or the other
    * event is processed.
    */
-  event<Time> operator|(const event<Time> &other) const {
+  basic_event operator|(const basic_event &other) const {
     assert(data_);
     return data_->sim_.any_of(*this, other);
   }
@@ -203,7 +298,7 @@ public:
    * @return New pending event which is triggered when this event and the other
    * event are processed.
    */
-  event<Time> operator&(const event<Time> &other) const {
+  basic_event operator&(const basic_event &other) const {
     assert(data_);
     return data_->sim_.all_of(*this, other);
   }
@@ -213,51 +308,372 @@ public:
    * @param other Other event.
    * @return Whether this event is equal to the other event.
    */
-  bool operator==(const event<Time> &other) const {
+  bool operator==(const basic_event &other) const {
     return data_ == other.data_;
   }
 
-  /// Abstract base class for all promise types.
+  /**
+   * Base class for all promise types. Promises are only destroyed with their
+   * coroutine frame, which knows their actual type, so the destructor is not
+   * virtual.
+   */
   class generic_promise_type {
   public:
-    /// Constructor.
-    generic_promise_type(simulation<Time> &sim, std::coroutine_handle<> handle)
-        : sim_{sim}, handle_{handle} {
-      sim_.handles_.insert(handle_);
+    /**
+     * Constructor.
+     *
+     * @param sim Reference to the simulation.
+     * @param handle Coroutine handle.
+     * @param ev Event associated with the process, a member of the derived
+     * promise type. Only referenced, so it may not be constructed yet.
+     */
+    generic_promise_type(Simulation &sim, std::coroutine_handle<> handle,
+                         const basic_event &ev)
+        : sim_{sim}, handle_{handle}, ev_{&ev}, next_{sim.processes_} {
+      if (next_) {
+        next_->prev_ = this;
+      }
+      sim_.processes_ = this;
     }
 
     /// Destructor.
-    virtual ~generic_promise_type() { sim_.handles_.erase(handle_); };
+    ~generic_promise_type() {
+      if (prev_) {
+        prev_->next_ = next_;
+      } else {
+        sim_.processes_ = next_;
+      }
+
+      if (next_) {
+        next_->prev_ = prev_;
+      }
+    };
+
+    generic_promise_type(const generic_promise_type &) = delete;
+    generic_promise_type &operator=(const generic_promise_type &) = delete;
+
+    /**
+     * Function cancelling the wait of a suspended process, so that it is not
+     * resumed by the awaited event or awaitable anymore.
+     */
+    using cancel_function = void (*)(generic_promise_type &);
+
+    /**
+     * Called by awaitables after suspending the process, so that the wait can
+     * be cancelled if the process is interrupted. If an interrupt is pending,
+     * it is delivered immediately.
+     *
+     * @param waiter Event data or awaitable the process waits on, passed to
+     * the cancel function with waiter.
+     * @param cancel Function cancelling the wait.
+     */
+    void wait(void *waiter, cancel_function cancel) {
+      waiter_ = waiter;
+      cancel_ = cancel;
+
+      if (interrupt_) {
+        deliver_interrupt();
+      }
+    }
+
+    /**
+     * Called by awaitables before the process is resumed or scheduled to be
+     * resumed. The wait cannot be cancelled anymore.
+     */
+    void end_wait() { cancel_ = nullptr; }
+
+    /**
+     * @return Event data or awaitable the process waits on, as given to
+     * wait.
+     */
+    void *waiter() const { return waiter_; }
+
+    /**
+     * Interrupt the process. See basic_event::interrupt.
+     *
+     * @param cause Cause of the interrupt.
+     */
+    void interrupt(std::any cause) {
+      interrupt_ = std::move(cause);
+
+      if (cancel_) {
+        deliver_interrupt();
+      }
+    }
+
+    /// @return Whether an interrupt is not delivered yet.
+    bool interrupt_pending() const { return interrupt_.has_value(); }
+
+    /**
+     * Take the pending interrupt to throw it.
+     *
+     * @return Cause of the interrupt.
+     */
+    std::any take_interrupt() {
+      assert(interrupt_);
+      auto cause = std::move(*interrupt_);
+      interrupt_.reset();
+      return cause;
+    }
 
     /// @return Event associated with the process.
-    virtual const event<Time> &process_event() const = 0;
+    const basic_event &process_event() const { return *ev_; }
 
     /// @return Coroutine handle associated with the process.
     std::coroutine_handle<> process_handle() const { return handle_; }
 
     /**
-     * Called when the coroutine is started. The coroutine awaits the return
-     * value before running.
+     * Called to allocate the coroutine frame. The frame is taken from the pool
+     * of the simulation.
+     *
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param size Size of the coroutine frame.
+     * @param sim Reference to the simulation.
+     * @return Pointer to the coroutine frame.
+     */
+    template <typename... Args>
+    FSCHUETZ04_SIMCPP20_ALWAYS_INLINE static void *
+    operator new(std::size_t size, Simulation &sim, Args &&...) {
+      return allocate_frame(size, sim);
+    }
+
+    /**
+     * Called to allocate the coroutine frame. The frame is taken from the pool
+     * of the simulation.
      *
-     * @return Event which will be processed at the current simulation time.
+     * @tparam Class Class type if the coroutine function is a lambda or a
+     * member function of a class.
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param size Size of the coroutine frame.
+     * @param sim Reference to the simulation.
+     * @return Pointer to the coroutine frame.
      */
-    event<Time> initial_suspend() const { return sim_.timeout(Time{0}); }
+    template <typename Class, typename... Args>
+    FSCHUETZ04_SIMCPP20_ALWAYS_INLINE static void *
+    operator new(std::size_t size, Class &&, Simulation &sim, Args &&...) {
+      return allocate_frame(size, sim);
+    }
+
+    /**
+     * Called to allocate the coroutine frame. The frame is taken from the pool
+     * of the simulation.
+     *
+     * @tparam Class Class type if the coroutine function is a member function
+     * of a class. Must contain a member variable sim referencing the simulation
+     * instance.
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param size Size of the coroutine frame.
+     * @param c Class instance.
+     * @return Pointer to the coroutine frame.
+     */
+    template <typename Class, typename... Args>
+    FSCHUETZ04_SIMCPP20_ALWAYS_INLINE static void *
+    operator new(std::size_t size, Class &&c, Args &&...) {
+      return allocate_frame(size, c.sim);
+    }
+
+    /**
+     * Called to free the coroutine frame. The frame is returned to the pool it
+     * was taken from.
+     *
+     * @param ptr Pointer to the coroutine frame.
+     * @param size Size of the coroutine frame.
+     */
+    static void operator delete(void *ptr, std::size_t size) noexcept {
+      auto frame = static_cast<std::byte *>(ptr) - frame_header_size;
+      auto frame_pool = *reinterpret_cast<pool **>(frame);
+      frame_pool->deallocate(frame, size + frame_header_size,
+                             memory_kind::frames);
+    }
+
+    /// Awaitable deferring the start of a process to the simulation.
+    class start_awaiter {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param promise Promise of the process to start.
+       */
+      explicit start_awaiter(generic_promise_type &promise)
+          : promise_{promise} {}
+
+      /// @return Whether the process can start immediately, which is never.
+      bool await_ready() const { return false; }
+
+      /// Schedule the process to be started at the current simulation time.
+      void await_suspend(std::coroutine_handle<>) const {
+        promise_.sim_.start(promise_);
+      }
+
+      /// Called when the process is started.
+      void await_resume() const {}
+
+    private:
+      /// Promise of the process to start.
+      generic_promise_type &promise_;
+    };
+
+    /**
+     * Called when the coroutine is started. The coroutine is suspended and
+     * scheduled to be started at the current simulation time, in the order
+     * the processes were created.
+     *
+     * @return Awaitable deferring the start of the process.
+     */
+    start_awaiter initial_suspend() { return start_awaiter{*this}; }
 
     /// Called when an exception is thrown inside the coroutine and not handled.
     void unhandled_exception() const { assert(false); }
 
+    /// Awaitable finishing a process, see final_suspend.
+    class final_awaiter {
+    public:
+      /**
+       * Constructor.
+       *
+       * @param promise Promise of the finishing process.
+       */
+      explicit final_awaiter(generic_promise_type &promise)
+          : promise_{promise} {}
+
+      /// @return Whether the coroutine is not suspended, which is never.
+      bool await_ready() const noexcept { return false; }
+
+      /**
+       * Complete the event of the process and destroy the coroutine.
+       *
+       * @param handle Coroutine handle of the process.
+       * @return Coroutine handle of the awaiting process to resume directly, or
+       * a no-op coroutine handle to return to the simulation.
+       */
+      std::coroutine_handle<>
+      await_suspend(std::coroutine_handle<> handle) const noexcept {
+        // The awaiter lives in the coroutine frame, so it must not be accessed
+        // after the coroutine is destroyed.
+        auto next = promise_.complete();
+        handle.destroy();
+        return next;
+      }
+
+      /// Never called, since the coroutine is destroyed while suspended.
+      void await_resume() const noexcept {}
+
+    private:
+      /// Promise of the finishing process.
+      generic_promise_type &promise_;
+    };
+
     /**
-     * Called after the coroutine returns.
+     * Called after the coroutine returns. See complete.
      *
-     * @return Awaitable which is always ready.
+     * @return Awaitable completing the event of the process, destroying the
+     * coroutine and possibly resuming the awaiting process.
      */
-    std::suspend_never final_suspend() const noexcept { return {}; }
+    final_awaiter final_suspend() noexcept { return final_awaiter{*this}; }
 
     /// Reference to the simulation.
-    simulation<Time> &sim_;
+    Simulation &sim_;
 
     /// Coroutine handle.
     std::coroutine_handle<> handle_;
+
+    /// ID of the process, which is the ID of its start entry.
+    std::uint64_t id_ = 0;
+
+  protected:
+    /// Whether the coroutine returned, so that its event is completed.
+    bool returned_ = false;
+
+  private:
+    /**
+     * Complete the event of a process which returned. If the event is awaited
+     * by exactly one process and has no callbacks, it is processed right away
+     * and the awaiting process is resumed directly by symmetric transfer,
+     * before other events at the current time. Otherwise, the event is
+     * triggered and processed in the order of scheduling.
+     *
+     * @return Coroutine handle of the process to resume directly, or a no-op
+     * coroutine handle.
+     */
+    std::coroutine_handle<> complete() {
+      ev_->data_->process_ = nullptr;
+      if (!returned_) {
+        return std::noop_coroutine();
+      }
+
+      auto &ev = *ev_;
+      auto &data = *ev.data_;
+      if (data.state_ != state::pending || data.promises_.size() != 1 ||
+          !data.cbs_.empty() || data.promises_[0]->process_event().aborted()) {
+        ev.trigger();
+        return std::noop_coroutine();
+      }
+
+      auto parent = data.promises_[0];
+      data.promises_.clear();
+      data.state_ = state::processed;
+      parent->end_wait();
+
+      // An interrupt of this process was not delivered and stays pending.
+      sim_.interrupted_ = nullptr;
+
+      auto &observer = sim_.observer_;
+      observer.on_process(1, 0);
+      observer.on_resume(parent->id_);
+      return parent->handle_;
+    }
+
+    /**
+     * Cancel the wait of the process and schedule it to be resumed to throw
+     * the interrupt.
+     */
+    void deliver_interrupt() {
+      std::exchange(cancel_, nullptr)(*this);
+      sim_.resume(*this, true);
+    }
+
+    /// Event associated with the process.
+    const basic_event *ev_;
+
+    /// Event data or awaitable the process waits on, see wait.
+    void *waiter_ = nullptr;
+
+    /// Function cancelling the wait, or null if it cannot be cancelled.
+    cancel_function cancel_ = nullptr;
+
+    /// Cause of the interrupt which is not delivered yet, if any.
+    std::optional<std::any> interrupt_;
+
+    /// Previous promise in the list of pending processes of the simulation.
+    generic_promise_type *prev_ = nullptr;
+
+    /// Next promise in the list of pending processes of the simulation.
+    generic_promise_type *next_;
+
+    /**
+     * Size of the header in front of each coroutine frame, which stores the
+     * pool the frame was taken from. A multiple of the pool granularity to
+     * keep the frame aligned.
+     */
+    static constexpr std::size_t frame_header_size = pool::granularity;
+
+    static_assert(sizeof(pool *) <= frame_header_size);
+
+    /**
+     * @param size Size of the coroutine frame.
+     * @param sim Reference to the simulation.
+     * @return Pointer to the coroutine frame, preceded by a header storing the
+     * pool of the simulation.
+     */
+    static void *allocate_frame(std::size_t size, Simulation &sim) {
+      auto frame = static_cast<std::byte *>(
+          sim.pool_.allocate(size + frame_header_size, memory_kind::frames));
+      ::new (frame) pool *{&sim.pool_};
+      return frame + frame_header_size;
+    }
   };
 
   /// Promise type for a coroutine returning an event.
@@ -273,8 +689,8 @@ public:
      * @param sim Reference to the simulation.
      */
     template <typename... Args>
-    explicit promise_type(simulation<Time> &sim, Args &&...)
-        : generic_promise_type{sim, handle_type::from_promise(*this)},
+    explicit promise_type(Simulation &sim, Args &&...)
+        : generic_promise_type{sim, handle_type::from_promise(*this), ev_},
           ev_{sim} {}
 
     /**
@@ -287,8 +703,8 @@ public:
      * @param sim Reference to the simulation.
      */
     template <typename Class, typename... Args>
-    explicit promise_type(Class &&, simulation<Time> &sim, Args &&...)
-        : generic_promise_type{sim, handle_type::from_promise(*this)},
+    explicit promise_type(Class &&, Simulation &sim, Args &&...)
+        : generic_promise_type{sim, handle_type::from_promise(*this), ev_},
           ev_{sim} {}
 
     /**
@@ -303,7 +719,7 @@ public:
      */
     template <typename Class, typename... Args>
     explicit promise_type(Class &&c, Args &&...)
-        : generic_promise_type{c.sim, handle_type::from_promise(*this)},
+        : generic_promise_type{c.sim, handle_type::from_promise(*this), ev_},
           ev_{c.sim} {}
 
 #ifdef __INTELLISENSE__
@@ -311,28 +727,29 @@ public:
     promise_type();
 #endif
 
-    /// @return Event associated with the process.
-    const event<Time> &process_event() const override { return ev_; }
-
     /**
      * Called to get the return value of the coroutine function.
      *
      * @return Event associated with the coroutine. This event is triggered
      * when the coroutine returns.
      */
-    event<Time> get_return_object() const { return ev_; }
+    basic_event get_return_object() const { return ev_; }
 
     /**
-     * Called when the coroutine returns. Trigger the event associated with the
-     * coroutine.
+     * Called when the coroutine returns. The event associated with the
+     * coroutine is completed after the coroutine finished, see
+     * generic_promise_type::final_suspend.
      */
-    void return_void() const { ev_.trigger(); }
+    void return_void() {
+      this->sim_.observer_.on_process_end(this->id_);
+      this->returned_ = true;
+    }
 
     /**
      * Event associated with the coroutine. This event is triggered when the
      * coroutine returns.
      */
-    event<Time> ev_;
+    basic_event ev_;
   };
 
 protected:
@@ -349,12 +766,22 @@ protected:
 
     data_->state_ = state::processed;
 
-    std::vector<generic_promise_type *> temp_promises;
-    data_->promises_.swap(temp_promises);
+    auto &observer = data_->sim_.observer_;
+    observer.on_process(data_->promises_.size(), data_->cbs_.size());
+
+    // End all waits before resuming any process, so that a process
+    // interrupting another one waiting for this event does not schedule it
+    // to be resumed a second time.
+    auto temp_promises = std::move(data_->promises_);
+    for (auto &promise : temp_promises) {
+      promise->end_wait();
+    }
+
     for (auto &promise : temp_promises) {
       if (promise->process_event().aborted()) {
         promise->process_handle().destroy();
       } else {
+        observer.on_resume(promise->id_);
         promise->process_handle().resume();
       }
     }
@@ -384,55 +811,161 @@ protected:
   /// Shared data of the event.
   class data {
   public:
+    /**
+     * Function destroying shared data of its actual type and releasing its
+     * memory.
+     */
+    using destroy_function = void (*)(data *);
+
+    /// Type of the callbacks added to the event.
+    using callback_type = callback<void(const basic_event &)>;
+
+    /// Type of the list of promises awaiting the event.
+    using promise_list =
+        small_vector<generic_promise_type *, 1,
+                     pool_allocator<generic_promise_type *,
+                                    memory_kind::waiters>>;
+
+    /// Type of the list of callbacks added to the event.
+    using callback_list =
+        small_vector<callback_type, 1,
+                     pool_allocator<callback_type, memory_kind::callbacks>>;
+
     /**
      * Constructor.
      *
      * @param sim Reference to the simulation.
+     * @param destroy Function destroying the shared data. Derived types pass
+     * their own function.
      */
-    explicit data(simulation<Time> &sim) : sim_{sim} {}
+    explicit data(Simulation &sim, destroy_function destroy = &destroy_data)
+        : destroy_{destroy},
+          promises_{typename promise_list::allocator_type{sim.pool_}},
+          cbs_{typename callback_list::allocator_type{sim.pool_}},
+          sim_{sim} {}
 
-    /// Destructor.
-    virtual ~data() {}
+    /**
+     * Destructor. Processes can only still wait for the event if their
+     * coroutines are being destroyed, so their promises are not accessed.
+     */
+    ~data() = default;
+
+    data(const data &) = delete;
+    data &operator=(const data &) = delete;
+
+    /**
+     * Destroy shared data of this type and return its memory to the pool of
+     * the simulation.
+     *
+     * @param d Shared data.
+     */
+    static void destroy_data(data *d) {
+      auto &sim_pool = d->sim_.pool_;
+      d->~data();
+      sim_pool.deallocate(d, sizeof(data), memory_kind::events);
+    }
+
+    /**
+     * Function destroying the shared data. Called when the last event
+     * referencing it is destroyed.
+     */
+    destroy_function destroy_;
+
+    /// Number of events referencing the shared data.
+    std::size_t ref_count_ = 1;
 
     /// State of the event.
     state state_ = state::pending;
 
-    /// Promises awaiting the event.
-    std::vector<generic_promise_type *> promises_ = {};
+    /**
+     * Promises awaiting the event. Most events are awaited by at most one
+     * process, which is stored inline. Longer lists are allocated from the
+     * pool of the simulation.
+     */
+    promise_list promises_;
 
-    /// Callbacks added to the event.
-    std::vector<std::function<void(const event<Time> &)>> cbs_ = {};
+    /**
+     * Callbacks added to the event. The first one is stored inline, longer
+     * lists are allocated from the pool of the simulation.
+     */
+    callback_list cbs_;
 
     /// Reference to the simulation.
-    simulation<Time> &sim_;
+    Simulation &sim_;
+
+    /// Promise of the process if this is the event of a process, or null.
+    generic_promise_type *process_ = nullptr;
+
+    /// Value of queue_id_ while the event is not queued.
+    static constexpr std::uint64_t unqueued =
+        std::numeric_limits<std::uint64_t>::max();
+
+    /**
+     * ID of the live queue entry of the event, or unqueued. Queue entries of
+     * the event with other IDs were cancelled or rescheduled and are skipped.
+     */
+    std::uint64_t queue_id_ = unqueued;
+
+    /// Time of the live queue entry of the event, if it is queued.
+    typename Simulation::time_type queue_time_ = {};
   };
 
   /**
    * Constructor.
    *
-   * @param data Shared data.
+   * @param data Newly created shared data, whose reference is taken over.
    */
-  explicit event(const std::shared_ptr<data> &data_) : data_{data_} {
-    assert(data_);
+  explicit basic_event(data *data) : data_{data} { assert(data_); }
+
+  /**
+   * Stop a process from waiting for an event because it was interrupted.
+   *
+   * @param promise Promise of the process, waiting on the shared data of the
+   * event.
+   */
+  static void cancel_wait(generic_promise_type &promise) {
+    auto &promises = static_cast<data *>(promise.waiter())->promises_;
+    for (auto it = promises.begin(); it != promises.end(); ++it) {
+      if (*it == &promise) {
+        promises.erase(it);
+        return;
+      }
+    }
   }
 
-  /// Shared data of the event.
-  std::shared_ptr<data> data_;
+  /// Drop the reference to the shared data, destroying it if it was the last.
+  void release() noexcept {
+    if (data_ && --data_->ref_count_ == 0) {
+      data_->destroy_(data_);
+    }
+  }
+
+  /// Shared data of the event. Null after the event was moved from.
+  data *data_;
 
-  friend class simulation<Time>;
-  friend struct std::hash<event<Time>>;
+  friend Simulation;
+  friend struct std::hash<basic_event>;
 };
+
+/**
+ * One event of a simulation using the default queue.
+ *
+ * @tparam Time Type used for simulation time.
+ */
+template <typename Time = double> using event = basic_event<simulation<Time>>;
 } // namespace simcpp20
 
+#undef FSCHUETZ04_SIMCPP20_ALWAYS_INLINE
+
 namespace std {
-/// Specialization of std::hash for simcpp20::event.
-template <typename Time> struct hash<simcpp20::event<Time>> {
+/// Specialization of std::hash for simcpp20::basic_event.
+template <typename Simulation> struct hash<simcpp20::basic_event<Simulation>> {
   /**
    * @param ev Event.
    * @return Hash of the event.
    */
-  std::size_t operator()(const simcpp20::event<Time> &ev) const {
-    return std::hash<decltype(ev.data_.get())>()(ev.data_.get());
+  std::size_t operator()(const simcpp20::basic_event<Simulation> &ev) const {
+    return std::hash<decltype(ev.data_)>()(ev.data_);
   }
 };
 } // namespace std
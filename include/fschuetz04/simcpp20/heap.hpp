@@ -0,0 +1,180 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert>  // assert
+#include <cstddef>  // std::size_t
+#include <iterator> // std::make_move_iterator
+#include <utility>  // std::move
+#include <vector>   // std::erase_if, std::vector
+
+namespace simcpp20 {
+/**
+ * Queue of scheduled events implemented as an implicit d-ary min-heap.
+ *
+ * Every queue usable by the simulation provides the same interface as this
+ * class. Items are ordered by their greater-than operator, which must define a
+ * strict total order.
+ *
+ * @tparam Item Type of the queued items.
+ * @tparam Arity Number of children of each node.
+ */
+template <typename Item, std::size_t Arity> class d_ary_heap {
+public:
+  static_assert(Arity >= 2);
+
+  /// @return Whether the queue is empty.
+  bool empty() const { return items_.empty(); }
+
+  /// @return Number of queued items.
+  std::size_t size() const { return items_.size(); }
+
+  /// @return First item of the queue.
+  const Item &top() const {
+    assert(!empty());
+    return items_.front();
+  }
+
+  /// @param item Item to insert.
+  void push(Item item) {
+    items_.push_back(std::move(item));
+    sift_up(items_.size() - 1);
+  }
+
+  /**
+   * Insert many items. If at least as many items are inserted as are queued,
+   * the heap is rebuilt in O(n) instead of inserting each item in O(log n).
+   *
+   * @param items Items to insert. Their storage is reused if the queue is
+   * empty.
+   */
+  void push_many(std::vector<Item> items) {
+    if (items.size() < items_.size()) {
+      for (auto &item : items) {
+        push(std::move(item));
+      }
+      return;
+    }
+
+    if (items_.empty()) {
+      items_ = std::move(items);
+    } else {
+      items_.insert(items_.end(), std::make_move_iterator(items.begin()),
+                    std::make_move_iterator(items.end()));
+    }
+
+    heapify();
+  }
+
+  /**
+   * Remove the first item of the queue.
+   *
+   * @return Removed item.
+   */
+  Item pop() {
+    assert(!empty());
+
+    auto item = std::move(items_.front());
+    if (items_.size() > 1) {
+      items_.front() = std::move(items_.back());
+      items_.pop_back();
+      sift_down(0);
+    } else {
+      items_.pop_back();
+    }
+
+    return item;
+  }
+
+  /**
+   * Remove all items matching a predicate in O(n).
+   *
+   * @tparam Predicate Type of the predicate.
+   * @param pred Predicate called with each item.
+   * @return Number of removed items.
+   */
+  template <typename Predicate> std::size_t erase_if(Predicate pred) {
+    auto n = std::erase_if(items_, pred);
+    heapify();
+    return n;
+  }
+
+private:
+  /// Restore the heap order of all items in O(n).
+  void heapify() {
+    if (items_.size() < 2) {
+      return;
+    }
+
+    for (auto i = (items_.size() - 2) / Arity + 1; i-- > 0;) {
+      sift_down(i);
+    }
+  }
+
+  /// @param i Index of the item to move up until the heap is restored.
+  void sift_up(std::size_t i) {
+    auto item = std::move(items_[i]);
+
+    while (i > 0) {
+      auto parent = (i - 1) / Arity;
+      if (!(items_[parent] > item)) {
+        break;
+      }
+
+      items_[i] = std::move(items_[parent]);
+      i = parent;
+    }
+
+    items_[i] = std::move(item);
+  }
+
+  /// @param i Index of the item to move down until the heap is restored.
+  void sift_down(std::size_t i) {
+    auto n = items_.size();
+    auto item = std::move(items_[i]);
+
+    while (true) {
+      auto first = i * Arity + 1;
+      if (first >= n) {
+        break;
+      }
+
+      auto last = first + Arity < n ? first + Arity : n;
+      auto min = first;
+      for (auto child = first + 1; child < last; ++child) {
+        if (items_[min] > items_[child]) {
+          min = child;
+        }
+      }
+
+      if (!(item > items_[min])) {
+        break;
+      }
+
+      items_[i] = std::move(items_[min]);
+      i = min;
+    }
+
+    items_[i] = std::move(item);
+  }
+
+  /// Items in heap order.
+  std::vector<Item> items_;
+};
+
+/**
+ * Queue of scheduled events implemented as a binary heap.
+ *
+ * @tparam Item Type of the queued items.
+ */
+template <typename Item> using binary_heap = d_ary_heap<Item, 2>;
+
+/**
+ * Queue of scheduled events implemented as a 4-ary heap. Compared to a binary
+ * heap, the tree is half as deep and the children of a node share cache lines.
+ *
+ * @tparam Item Type of the queued items.
+ */
+template <typename Item> using quaternary_heap = d_ary_heap<Item, 4>;
+} // namespace simcpp20
@@ -0,0 +1,42 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+namespace simcpp20 {
+template <typename Time, template <typename> class Queue, typename Observer>
+class simulation;
+
+/**
+ * Source of messages posted from other threads, independent of the value
+ * type. Attached to one simulation, which drains it between two steps.
+ */
+class injection_source {
+public:
+  /// Destructor.
+  virtual ~injection_source() = default;
+
+protected:
+  /// Constructor.
+  injection_source() = default;
+
+  injection_source(const injection_source &) = delete;
+  injection_source &operator=(const injection_source &) = delete;
+
+  /**
+   * Schedule the messages posted since the last call in the simulation.
+   * Called by the simulation between two steps when a message was posted.
+   */
+  virtual void drain() = 0;
+
+private:
+  /// Previous source attached to the same simulation, or null.
+  injection_source *prev_ = nullptr;
+
+  /// Next source attached to the same simulation, or null.
+  injection_source *next_ = nullptr;
+
+  template <typename, template <typename> class, typename>
+  friend class simulation;
+};
+} // namespace simcpp20
@@ -0,0 +1,199 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm> // std::max
+#include <atomic>    // std::atomic, std::memory_order
+#include <deque>     // std::deque
+#include <utility>   // std::exchange, std::move
+
+#include "injection_source.hpp"
+#include "simulation.hpp"
+
+namespace simcpp20 {
+/**
+ * Queue of timestamped messages posted from other threads, for example the
+ * network threads of a co-simulation, and received by processes of one
+ * simulation:
+ *
+ *     simcpp20::injector<reading> readings{sim};
+ *     // on a network thread
+ *     readings.post(timestamp, reading);
+ *     // in a process
+ *     auto next = co_await readings.receive();
+ *
+ * post may be called from any thread, concurrently, without locking. It pushes
+ * the message onto a lock-free stack and, if the stack was empty, sets a flag
+ * of the simulation. Before each step, the simulation loads the flag with a
+ * relaxed atomic load, which is all that happens while nothing is posted. If
+ * the flag is set, the messages of all injectors of the simulation are
+ * scheduled at their timestamps, or at the current simulation time if their
+ * timestamps already passed. Messages posted by one thread with equal
+ * timestamps are received in the order they were posted.
+ *
+ * run and run_until return when no events are scheduled, so a simulation
+ * waiting only for posted messages must be kept busy, for example by a
+ * process waiting on a timer while running paced with basic_realtime.
+ *
+ * All members except post must only be used by the thread running the
+ * simulation. The injector must be destroyed before the simulation and must
+ * not be destroyed while messages are still posted or scheduled.
+ *
+ * @tparam Value Type of the messages.
+ * @tparam Simulation Type of the simulation.
+ */
+template <typename Value, typename Simulation>
+class basic_injector : public injection_source {
+public:
+  /// Type used for simulation time.
+  using time_type = typename Simulation::time_type;
+
+  /// Type of the value events returned by receive.
+  using value_event_type =
+      typename Simulation::template value_event_type<Value>;
+
+  /**
+   * Constructor.
+   *
+   * @param sim Reference to the simulation receiving the messages.
+   */
+  explicit basic_injector(Simulation &sim) : sim_{sim} { sim.attach(*this); }
+
+  /// Destructor. Messages which were posted, but not drained, are dropped.
+  ~basic_injector() override {
+    sim_.detach(*this);
+
+    auto node = head_.exchange(nullptr, std::memory_order_acquire);
+    while (node) {
+      delete std::exchange(node, node->next_);
+    }
+  }
+
+  /**
+   * Post a message. Thread-safe and lock-free. The message is allocated on
+   * the posting thread.
+   *
+   * @param time Simulation time at which the message is received.
+   * @param value Message.
+   */
+  void post(time_type time, Value value) {
+    auto node = new message{time, std::move(value), nullptr};
+    auto head = head_.load(std::memory_order_relaxed);
+    do {
+      node->next_ = head;
+    } while (!head_.compare_exchange_weak(
+        head, node, std::memory_order_release, std::memory_order_relaxed));
+
+    // Only the first message after a drain needs to set the flag: later ones
+    // are either drained with it or find the stack empty again.
+    if (!head) {
+      sim_.notify_injection();
+    }
+  }
+
+  /**
+   * Post a message which is received as soon as possible, at the simulation
+   * time of the next step. Thread-safe and lock-free.
+   *
+   * @param value Message.
+   */
+  void post(Value value) { post(time_type{0}, std::move(value)); }
+
+  /**
+   * Receive the next message. If no message has arrived yet, the returned
+   * event is triggered with the next arriving message. Aborting the returned
+   * event before it is triggered cancels the receive.
+   *
+   * @return Value event which is triggered with the message.
+   */
+  value_event_type receive() {
+    auto ev = sim_.template event<Value>();
+
+    if (inbox_.empty()) {
+      receivers_.push_back(ev);
+    } else {
+      ev.trigger(std::move(inbox_.front()));
+      inbox_.pop_front();
+    }
+
+    return ev;
+  }
+
+protected:
+  /// @see injection_source::drain
+  void drain() override {
+    // The stack holds the messages in reverse order of posting.
+    message *first = nullptr;
+    auto node = head_.exchange(nullptr, std::memory_order_acquire);
+    while (node) {
+      auto next = node->next_;
+      node->next_ = first;
+      first = node;
+      node = next;
+    }
+
+    while (first) {
+      auto ev = sim_.event();
+      ev.add_callback([this, value = std::move(first->value_)](
+                          const auto &) mutable { arrive(std::move(value)); });
+      sim_.schedule_at(ev, std::max(first->time_, sim_.now()));
+      delete std::exchange(first, first->next_);
+    }
+  }
+
+private:
+  /// Message which was posted, but not yet drained.
+  struct message {
+    /// Time at which the message is received.
+    time_type time_;
+
+    /// Message.
+    Value value_;
+
+    /// Message posted before this one, or after it once drained.
+    message *next_;
+  };
+
+  /**
+   * Pass an arriving message to the first waiting receiver, or keep it until
+   * the next receive.
+   *
+   * @param value Message.
+   */
+  void arrive(Value value) {
+    while (!receivers_.empty()) {
+      auto ev = receivers_.front();
+      receivers_.pop_front();
+
+      if (ev.pending()) {
+        ev.trigger(std::move(value));
+        return;
+      }
+    }
+
+    inbox_.push_back(std::move(value));
+  }
+
+  /// Reference to the simulation receiving the messages.
+  Simulation &sim_;
+
+  /// Most recently posted message, or null. Shared with the posting threads.
+  std::atomic<message *> head_ = nullptr;
+
+  /// Messages which arrived before a receive.
+  std::deque<Value> inbox_;
+
+  /// Receives waiting for a message.
+  std::deque<value_event_type> receivers_;
+};
+
+/**
+ * Injector of a simulation with the default queue.
+ *
+ * @tparam Value Type of the messages.
+ * @tparam Time Type used for simulation time.
+ */
+template <typename Value, typename Time = double>
+using injector = basic_injector<Value, simulation<Time>>;
+} // namespace simcpp20
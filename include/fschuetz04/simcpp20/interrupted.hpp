@@ -0,0 +1,45 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <any>       // std::any
+#include <exception> // std::exception
+#include <utility>   // std::move
+
+namespace simcpp20 {
+/**
+ * Exception thrown into a process by the co_await expression it is suspended
+ * in when the process is interrupted. See basic_event::interrupt.
+ *
+ * co_await is not allowed inside a handler, so a process which needs to wait
+ * after it was interrupted remembers the interrupt and waits after the
+ * handler:
+ *
+ *     bool failed = false;
+ *     try {
+ *       co_await sim.timeout(work_time);
+ *     } catch (const simcpp20::interrupted &) {
+ *       failed = true;
+ *     }
+ */
+class interrupted : public std::exception {
+public:
+  /**
+   * Constructor.
+   *
+   * @param cause Cause of the interrupt given to basic_event::interrupt.
+   */
+  explicit interrupted(std::any cause) : cause_{std::move(cause)} {}
+
+  /// @return Cause of the interrupt given to basic_event::interrupt.
+  const std::any &cause() const { return cause_; }
+
+  /// @return Description of the exception.
+  const char *what() const noexcept override { return "process interrupted"; }
+
+private:
+  /// Cause of the interrupt.
+  std::any cause_;
+};
+} // namespace simcpp20
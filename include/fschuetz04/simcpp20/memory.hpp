@@ -0,0 +1,113 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint8_t
+
+namespace simcpp20 {
+/// Kind of memory allocated from the pool of a simulation.
+enum class memory_kind : std::uint8_t {
+  /// Shared state of events.
+  events,
+  /// Coroutine frames of processes.
+  frames,
+  /// Entries of the queue of events scheduled without delay.
+  immediate,
+  /// Lists of processes awaiting an event which outgrow their inline storage.
+  waiters,
+  /// Callback lists which outgrow their inline storage and large callables.
+  callbacks,
+  /// Anything else.
+  other,
+};
+
+/// Number of kinds of memory.
+inline constexpr std::size_t n_memory_kinds =
+    static_cast<std::size_t>(memory_kind::other) + 1;
+
+/// Live memory of one kind allocated from a pool.
+struct memory_usage {
+  /// Number of live blocks.
+  std::size_t n_blocks_ = 0;
+
+  /// Number of requested bytes of the live blocks.
+  std::size_t bytes_ = 0;
+
+  /// Highest number of requested bytes of live blocks so far.
+  std::size_t peak_bytes_ = 0;
+
+  /// Comparison operator.
+  bool operator==(const memory_usage &) const = default;
+};
+
+/**
+ * Memory footprint of a simulation, returned by simulation::memory. All
+ * values are maintained while the simulation runs, so taking a report is
+ * cheap and can be done periodically during long runs.
+ *
+ * Each event and each pending process holds exactly one block of events_ and
+ * frames_, so a growing number of blocks points at events kept alive by
+ * copies or processes which never finish. Growing waiters_ points at events
+ * awaited by many processes, and growing callbacks_ at events with many or
+ * large callbacks.
+ */
+struct memory_report {
+  /// Shared state of live events.
+  memory_usage events_;
+
+  /// Coroutine frames of pending processes, one block per process.
+  memory_usage frames_;
+
+  /// Storage of the queue of events scheduled without delay.
+  memory_usage immediate_;
+
+  /**
+   * Lists of processes awaiting an event, for events awaited by more than one
+   * process.
+   */
+  memory_usage waiters_;
+
+  /**
+   * Lists of callbacks, for events with more than one callback, and callables
+   * too large to be stored inline.
+   */
+  memory_usage callbacks_;
+
+  /// Other memory allocated from the pool.
+  memory_usage other_;
+
+  /// Bytes held by the pool, including free blocks.
+  std::size_t pool_bytes_ = 0;
+
+  /**
+   * Entries in the queue of events scheduled with a delay, including
+   * discarded entries.
+   */
+  std::size_t n_scheduled_ = 0;
+
+  /// Highest number of entries in the queue of events scheduled with a delay.
+  std::size_t peak_scheduled_ = 0;
+
+  /// Size of one entry in the queue of events scheduled with a delay.
+  std::size_t scheduled_entry_size_ = 0;
+
+  /// Entries in the queue of events scheduled without delay.
+  std::size_t n_immediate_ = 0;
+
+  /// Discarded entries of aborted or rescheduled events in both queues.
+  std::size_t n_discarded_ = 0;
+
+  /// @return Number of pending processes.
+  std::size_t n_processes() const { return frames_.n_blocks_; }
+
+  /**
+   * @return Number of bytes of the entries in the queue of events scheduled
+   * with a delay, not counting unused capacity.
+   */
+  std::size_t scheduled_bytes() const {
+    return n_scheduled_ * scheduled_entry_size_;
+  }
+};
+} // namespace simcpp20
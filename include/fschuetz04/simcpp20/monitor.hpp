@@ -0,0 +1,404 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm> // std::clamp, std::max, std::min
+#include <array>     // std::array
+#include <cassert>   // assert
+#include <cmath>     // std::frexp, std::ldexp
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint64_t
+#include <limits>    // std::numeric_limits
+
+namespace simcpp20 {
+/// Counter of occurrences, for example of reneging customers.
+class counter {
+public:
+  /// @param n Number of occurrences to add.
+  void add(std::uint64_t n = 1) { value_ += n; }
+
+  /// @return Number of occurrences.
+  std::uint64_t value() const { return value_; }
+
+  /// @param other Counter to add the occurrences of.
+  void merge(const counter &other) { value_ += other.value_; }
+
+private:
+  /// Number of occurrences.
+  std::uint64_t value_ = 0;
+};
+
+/**
+ * Count, mean, variance, minimum and maximum of samples, for example of
+ * waiting times. The mean and variance are updated with Welford's algorithm,
+ * which is numerically stable.
+ *
+ * Like the other monitors, a tally uses a fixed amount of memory, is updated
+ * in O(1) without allocating and can be merged, for example to combine the
+ * results of run_replications:
+ *
+ *     auto waits = simcpp20::run_replications(
+ *         n, model, simcpp20::tally{}, [](auto all, const auto &one) {
+ *           all.merge(one);
+ *           return all;
+ *         });
+ */
+class tally {
+public:
+  /// @param value Sample to add.
+  void add(double value) {
+    ++n_;
+    auto delta = value - mean_;
+    mean_ += delta / static_cast<double>(n_);
+    m2_ += delta * (value - mean_);
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  /**
+   * Add the samples of another tally, as if they were added to this tally.
+   *
+   * @param other Tally to add the samples of.
+   */
+  void merge(const tally &other) {
+    if (other.n_ == 0) {
+      return;
+    }
+
+    auto n = n_ + other.n_;
+    auto delta = other.mean_ - mean_;
+    auto weight = static_cast<double>(other.n_) / static_cast<double>(n);
+    mean_ += delta * weight;
+    m2_ += other.m2_ + delta * delta * static_cast<double>(n_) * weight;
+    n_ = n;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+
+  /// @return Number of samples.
+  std::uint64_t count() const { return n_; }
+
+  /// @return Mean of the samples, or 0 if there are none.
+  double mean() const { return mean_; }
+
+  /// @return Sample variance, or 0 if there are less than two samples.
+  double variance() const {
+    return n_ < 2 ? 0 : m2_ / static_cast<double>(n_ - 1);
+  }
+
+  /// @return Smallest sample, or infinity if there are none.
+  double min() const { return min_; }
+
+  /// @return Largest sample, or minus infinity if there are none.
+  double max() const { return max_; }
+
+private:
+  /// Number of samples.
+  std::uint64_t n_ = 0;
+
+  /// Mean of the samples.
+  double mean_ = 0;
+
+  /// Sum of the squared differences from the mean.
+  double m2_ = 0;
+
+  /// Smallest sample.
+  double min_ = std::numeric_limits<double>::infinity();
+
+  /// Largest sample.
+  double max_ = -std::numeric_limits<double>::infinity();
+};
+
+/**
+ * Level which changes over simulation time, for example a queue length or the
+ * number of busy units of a resource, and its average weighted by the time
+ * each level was held:
+ *
+ *     simcpp20::time_weighted<> queue_length{sim.now()};
+ *     queue_length.add(sim.now(), 1);
+ *
+ * @tparam Time Type used for simulation time. Differences of two times must
+ * be convertible to double.
+ */
+template <typename Time = double> class time_weighted {
+public:
+  /// Constructor. The level 0 is held from time 0 on.
+  time_weighted() = default;
+
+  /**
+   * Constructor.
+   *
+   * @param start Simulation time from which on the level is held.
+   * @param level Initial level.
+   */
+  explicit time_weighted(Time start, double level = 0)
+      : last_{start}, level_{level}, min_{level}, max_{level} {}
+
+  /**
+   * @param now Current simulation time.
+   * @param level New level.
+   */
+  void set(Time now, double level) {
+    advance(now);
+    level_ = level;
+    min_ = std::min(min_, level);
+    max_ = std::max(max_, level);
+  }
+
+  /**
+   * @param now Current simulation time.
+   * @param delta Change of the level.
+   */
+  void add(Time now, double delta) { set(now, level_ + delta); }
+
+  /**
+   * Account for the current level up to the given time, for example at the
+   * end of a run before merging.
+   *
+   * @param now Current simulation time.
+   */
+  void advance(Time now) {
+    assert(now >= last_);
+    auto duration = static_cast<double>(now - last_);
+    integral_ += level_ * duration;
+    duration_ += duration;
+    last_ = now;
+  }
+
+  /**
+   * Add the accounted time of another monitor. The current level and time of
+   * this monitor are kept.
+   *
+   * @param other Monitor to add the accounted time of.
+   */
+  void merge(const time_weighted &other) {
+    integral_ += other.integral_;
+    duration_ += other.duration_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+
+  /// @return Current level.
+  double level() const { return level_; }
+
+  /**
+   * @return Time-weighted average of the level up to the last update, or the
+   * current level if no time was accounted.
+   */
+  double mean() const {
+    return duration_ > 0 ? integral_ / duration_ : level_;
+  }
+
+  /**
+   * @param now Current simulation time.
+   * @return Time-weighted average of the level up to the given time.
+   */
+  double mean(Time now) const {
+    auto copy = *this;
+    copy.advance(now);
+    return copy.mean();
+  }
+
+  /// @return Accounted simulation time.
+  double duration() const { return duration_; }
+
+  /// @return Integral of the level over the accounted time.
+  double integral() const { return integral_; }
+
+  /// @return Smallest level.
+  double min() const { return min_; }
+
+  /// @return Largest level.
+  double max() const { return max_; }
+
+private:
+  /// Simulation time of the last update.
+  Time last_ = Time{0};
+
+  /// Current level.
+  double level_ = 0;
+
+  /// Smallest level.
+  double min_ = 0;
+
+  /// Largest level.
+  double max_ = 0;
+
+  /// Integral of the level over the accounted time.
+  double integral_ = 0;
+
+  /// Accounted simulation time.
+  double duration_ = 0;
+};
+
+/**
+ * Histogram of non-negative samples with logarithmically sized buckets, used
+ * to estimate quantiles in fixed memory. Each power of two is split into
+ * n_sub_buckets buckets of equal width, so estimated quantiles have a
+ * relative error of at most 1 / (2 * n_sub_buckets). Samples between 0 and
+ * 2^min_exponent share one bucket, and samples of at least
+ * 2^(max_exponent + 1) are counted in the last bucket. Unlike the P²
+ * algorithm or t-digests, merging two histograms is exact.
+ */
+class quantile_histogram {
+public:
+  /// Number of buckets per power of two.
+  static constexpr std::size_t n_sub_buckets = 32;
+
+  /// Exponent of the smallest power of two with its own buckets.
+  static constexpr int min_exponent = -31;
+
+  /// Exponent of the largest power of two with its own buckets.
+  static constexpr int max_exponent = 32;
+
+  /// @param value Sample to add. Must not be negative.
+  void add(double value) {
+    assert(value >= 0);
+    ++buckets_[bucket(value)];
+    tally_.add(value);
+  }
+
+  /**
+   * @param q Quantile between 0 and 1.
+   * @return Estimate of the quantile of the samples, or 0 if there are none.
+   * The quantiles 0 and 1 are the exact smallest and largest samples.
+   */
+  double quantile(double q) const {
+    assert(q >= 0 && q <= 1);
+    if (count() == 0) {
+      return 0;
+    }
+
+    if (q == 0) {
+      return tally_.min();
+    }
+
+    if (q == 1) {
+      return tally_.max();
+    }
+
+    auto rank = static_cast<std::uint64_t>(q * static_cast<double>(count()));
+    std::uint64_t seen = 0;
+    std::size_t i = 0;
+    for (; i < n_buckets - 1; ++i) {
+      seen += buckets_[i];
+      if (seen > rank) {
+        break;
+      }
+    }
+
+    return std::clamp(midpoint(i), tally_.min(), tally_.max());
+  }
+
+  /// @param other Histogram to add the samples of.
+  void merge(const quantile_histogram &other) {
+    for (std::size_t i = 0; i < n_buckets; ++i) {
+      buckets_[i] += other.buckets_[i];
+    }
+
+    tally_.merge(other.tally_);
+  }
+
+  /// @return Number of samples.
+  std::uint64_t count() const { return tally_.count(); }
+
+  /// @return Count, mean, variance, minimum and maximum of the samples.
+  const tally &summary() const { return tally_; }
+
+private:
+  /// Number of buckets: one for the smallest samples, then per power of two.
+  static constexpr std::size_t n_buckets =
+      1 + (max_exponent - min_exponent + 1) * n_sub_buckets;
+
+  /**
+   * @param value Sample.
+   * @return Index of the bucket counting the sample.
+   */
+  static std::size_t bucket(double value) {
+    int exp;
+    auto mantissa = std::frexp(value, &exp);
+    // value = mantissa * 2^exp with mantissa in [0.5, 1), so value is in
+    // [2^(exp - 1), 2^exp).
+    if (value == 0 || exp <= min_exponent) {
+      return 0;
+    }
+
+    if (exp > max_exponent + 1) {
+      return n_buckets - 1;
+    }
+
+    auto sub = static_cast<std::size_t>((2 * mantissa - 1) * n_sub_buckets);
+    return 1 + static_cast<std::size_t>(exp - 1 - min_exponent) *
+                   n_sub_buckets +
+           sub;
+  }
+
+  /**
+   * @param i Index of a bucket.
+   * @return Midpoint of the values counted in the bucket.
+   */
+  static double midpoint(std::size_t i) {
+    if (i == 0) {
+      return std::ldexp(0.5, min_exponent);
+    }
+
+    auto exp = static_cast<int>((i - 1) / n_sub_buckets) + min_exponent;
+    auto sub = static_cast<double>((i - 1) % n_sub_buckets);
+    return std::ldexp(1 + (sub + 0.5) / n_sub_buckets, exp);
+  }
+
+  /// Number of samples in each bucket.
+  std::array<std::uint64_t, n_buckets> buckets_ = {};
+
+  /// Summary of the samples.
+  tally tally_;
+};
+
+/**
+ * Time-weighted levels of a resource, updated by the resource it is attached
+ * to with basic_resource::monitor. Attaching the monitor resets it, so it
+ * accounts the time from then on.
+ *
+ * @tparam Time Type used for simulation time.
+ */
+template <typename Time = double> struct resource_monitor {
+  /**
+   * Set both levels.
+   *
+   * @param now Current simulation time.
+   * @param n_in_use Number of units in use.
+   * @param n_waiting Number of waiting requests.
+   */
+  void set(Time now, double n_in_use, double n_waiting) {
+    in_use.set(now, n_in_use);
+    queue_length.set(now, n_waiting);
+  }
+
+  /// @param now Current simulation time.
+  void advance(Time now) {
+    in_use.advance(now);
+    queue_length.advance(now);
+  }
+
+  /// @param other Monitor to add the accounted time of.
+  void merge(const resource_monitor &other) {
+    in_use.merge(other.in_use);
+    queue_length.merge(other.queue_length);
+  }
+
+  /**
+   * @param capacity Number of units of the resource.
+   * @return Average fraction of units in use up to the last update.
+   */
+  double utilization(std::uint64_t capacity) const {
+    return in_use.mean() / static_cast<double>(capacity);
+  }
+
+  /// Number of units in use.
+  time_weighted<Time> in_use;
+
+  /// Number of waiting requests.
+  time_weighted<Time> queue_length;
+};
+} // namespace simcpp20
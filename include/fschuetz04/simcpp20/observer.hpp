@@ -0,0 +1,217 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <array>   // std::array
+#include <bit>     // std::bit_width
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+
+namespace simcpp20 {
+/**
+ * Observer of a simulation which does nothing. The simulation calls the hooks
+ * of its observer statically, so every hook of this class compiles away.
+ *
+ * Custom observers provide the same member functions. Their first parameter
+ * is the simulation time where applicable.
+ */
+struct no_observer {
+  /**
+   * Called when a queue entry is inserted: when an event is scheduled, and
+   * when a process is scheduled to be started or to be resumed without an
+   * event. Each entry is later reported to on_step, unless it is discarded.
+   *
+   * @param now Current simulation time.
+   * @param time Time at which the entry will be taken from the queue.
+   * @param id ID of the queue entry.
+   */
+  template <typename Time>
+  void on_schedule(Time now, Time time, std::uint64_t id) {
+    (void)now;
+    (void)time;
+    (void)id;
+  }
+
+  /**
+   * Called when the next queue entry is taken from the queue, which processes
+   * an event, or starts or resumes a process.
+   *
+   * @param now Current simulation time, already advanced to the time of the
+   * event.
+   * @param id ID of the queue entry.
+   * @param n_scheduled Number of entries remaining in the queue.
+   */
+  template <typename Time>
+  void on_step(Time now, std::uint64_t id, std::size_t n_scheduled) {
+    (void)now;
+    (void)id;
+    (void)n_scheduled;
+  }
+
+  /**
+   * Called when an event is processed, before any coroutine is resumed.
+   *
+   * @param n_promises Number of coroutines awaiting the event.
+   * @param n_callbacks Number of callbacks added to the event.
+   */
+  void on_process(std::size_t n_promises, std::size_t n_callbacks) {
+    (void)n_promises;
+    (void)n_callbacks;
+  }
+
+  /**
+   * Called before a suspended coroutine is resumed.
+   *
+   * @param process ID of the process, which is the ID of its start entry.
+   */
+  void on_resume(std::uint64_t process) { (void)process; }
+
+  /**
+   * Called when an aborted process is taken from the queue.
+   *
+   * @param id ID of the queue entry.
+   */
+  void on_abort(std::uint64_t id) { (void)id; }
+
+  /**
+   * Called before a process is started.
+   *
+   * @param process ID of the process.
+   */
+  void on_process_start(std::uint64_t process) { (void)process; }
+
+  /**
+   * Called when a process returns.
+   *
+   * @param process ID of the process.
+   */
+  void on_process_end(std::uint64_t process) { (void)process; }
+};
+
+/**
+ * Histogram with one bucket per power of two. Bucket 0 counts the value 0,
+ * and bucket i > 0 counts values in [2^(i - 1), 2^i).
+ */
+class log2_histogram {
+public:
+  /// @param value Value to add.
+  void add(std::uint64_t value) { ++buckets_[std::bit_width(value)]; }
+
+  /**
+   * @param i Index of the bucket.
+   * @return Number of values in the bucket.
+   */
+  std::uint64_t operator[](std::size_t i) const { return buckets_[i]; }
+
+  /// @return Number of buckets.
+  static constexpr std::size_t size() { return n_buckets; }
+
+  /// @param other Histogram to add the counts of.
+  void merge(const log2_histogram &other) {
+    for (std::size_t i = 0; i < size(); ++i) {
+      buckets_[i] += other.buckets_[i];
+    }
+  }
+
+private:
+  /// Number of buckets, one for 0 and one per bit width of a 64-bit value.
+  static constexpr std::size_t n_buckets = 65;
+
+  /// Number of values in each bucket.
+  std::array<std::uint64_t, n_buckets> buckets_ = {};
+};
+
+/**
+ * Observer counting what happens in a simulation. Cheap enough to be enabled
+ * in production runs.
+ *
+ * @tparam Time Type used for simulation time.
+ */
+template <typename Time = double> class counting_observer {
+public:
+  /// @see no_observer::on_schedule
+  void on_schedule(Time, Time, std::uint64_t) { ++n_scheduled_; }
+
+  /// @see no_observer::on_step
+  void on_step(Time now, std::uint64_t, std::size_t n_scheduled) {
+    if (n_steps_ > 0 && now == burst_time_) {
+      ++burst_size_;
+    } else {
+      if (burst_size_ > 0) {
+        burst_sizes_.add(burst_size_);
+      }
+
+      burst_time_ = now;
+      burst_size_ = 1;
+    }
+
+    ++n_steps_;
+    queue_sizes_.add(n_scheduled);
+    if (n_scheduled > max_queue_size_) {
+      max_queue_size_ = n_scheduled;
+    }
+  }
+
+  /// @see no_observer::on_process
+  void on_process(std::size_t n_promises, std::size_t) {
+    ++n_processed_;
+    promises_per_event_.add(n_promises);
+  }
+
+  /// @see no_observer::on_resume
+  void on_resume(std::uint64_t) { ++n_resumed_; }
+
+  /// @see no_observer::on_abort
+  void on_abort(std::uint64_t) { ++n_aborted_; }
+
+  /// @see no_observer::on_process_start
+  void on_process_start(std::uint64_t) { ++n_started_; }
+
+  /// @see no_observer::on_process_end
+  void on_process_end(std::uint64_t) { ++n_finished_; }
+
+  /// Number of queue entries, including process starts and resumes.
+  std::uint64_t n_scheduled_ = 0;
+
+  /// Number of queue entries taken from the queue.
+  std::uint64_t n_steps_ = 0;
+
+  /// Number of processed events.
+  std::uint64_t n_processed_ = 0;
+
+  /// Number of resumed coroutines.
+  std::uint64_t n_resumed_ = 0;
+
+  /// Number of aborted processes taken from the queue.
+  std::uint64_t n_aborted_ = 0;
+
+  /// Number of started processes.
+  std::uint64_t n_started_ = 0;
+
+  /// Number of processes which returned.
+  std::uint64_t n_finished_ = 0;
+
+  /// Largest number of entries remaining in the queue after a step.
+  std::size_t max_queue_size_ = 0;
+
+  /// Number of entries remaining in the queue after each step.
+  log2_histogram queue_sizes_;
+
+  /**
+   * Number of consecutive steps at the same simulation time. The burst at the
+   * current simulation time is only added once the time advances.
+   */
+  log2_histogram burst_sizes_;
+
+  /// Number of coroutines awaiting each processed event.
+  log2_histogram promises_per_event_;
+
+private:
+  /// Simulation time of the current burst.
+  Time burst_time_ = Time{0};
+
+  /// Number of steps in the current burst.
+  std::uint64_t burst_size_ = 0;
+};
+} // namespace simcpp20
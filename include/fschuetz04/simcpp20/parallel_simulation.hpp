@@ -0,0 +1,245 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert>            // assert
+#include <condition_variable> // std::condition_variable
+#include <cstddef>            // std::size_t
+#include <memory>             // std::make_unique, std::unique_ptr
+#include <mutex>              // std::mutex, std::unique_lock
+#include <optional>           // std::optional, std::nullopt
+#include <thread>             // std::thread
+#include <utility>            // std::move
+#include <vector>             // std::vector
+
+#include "channel.hpp"
+#include "simulation.hpp"
+
+namespace simcpp20 {
+/**
+ * Conservative parallel discrete-event simulation. The model is split into
+ * logical processes, each with its own simulation, which are connected by
+ * channels with a positive lookahead. While running, each simulation runs on
+ * its own thread.
+ *
+ * The simulations are synchronized in windows. A window starts at the time of
+ * the earliest scheduled event of all simulations and ends one lookahead (the
+ * smallest of all channels) later. No message sent during the window can
+ * arrive before its end, so all simulations process the events before the end
+ * of the window independently. Between windows, the messages sent during the
+ * window are scheduled in the receiving simulations in a fixed order, so the
+ * results do not depend on the number of threads or their timing.
+ *
+ * Processes of a simulation may only access their own simulation and the
+ * channels from and to it.
+ *
+ * @tparam Time Type used for simulation time.
+ */
+template <typename Time = double> class parallel_simulation {
+public:
+  /// Type of the simulations of the logical processes.
+  using simulation_type = simulation<Time>;
+
+  /**
+   * Constructor.
+   *
+   * @param n Number of logical processes.
+   */
+  explicit parallel_simulation(std::size_t n) {
+    sims_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      sims_.push_back(std::make_unique<simulation_type>());
+    }
+  }
+
+  /// @return Number of logical processes.
+  std::size_t size() const { return sims_.size(); }
+
+  /**
+   * @param i Index of the logical process.
+   * @return Reference to the simulation of the logical process.
+   */
+  simulation_type &operator[](std::size_t i) {
+    assert(i < size());
+    return *sims_[i];
+  }
+
+  /**
+   * Create a channel between two logical processes.
+   *
+   * @tparam Value Type of the messages.
+   * @param src Index of the sending logical process.
+   * @param dst Index of the receiving logical process.
+   * @param lookahead Smallest delay between sending and receiving a message.
+   * Must be positive.
+   * @return Reference to the channel, which lives as long as the parallel
+   * simulation.
+   */
+  template <typename Value>
+  channel<Value, Time> &connect(std::size_t src, std::size_t dst,
+                                Time lookahead) {
+    std::unique_ptr<channel<Value, Time>> ch{
+        new channel<Value, Time>{(*this)[src], (*this)[dst], lookahead}};
+    auto &ref = *ch;
+    channels_.push_back(std::move(ch));
+
+    if (!lookahead_ || lookahead < *lookahead_) {
+      lookahead_ = lookahead;
+    }
+
+    return ref;
+  }
+
+  /**
+   * Run the simulations until no more events are scheduled. Afterwards, the
+   * current time of a simulation may be later than its last event, since
+   * simulations advance to the end of each window.
+   */
+  void run() { run_windows(std::nullopt); }
+
+  /**
+   * Run the simulations until the target time is reached or no more events
+   * are scheduled. Afterwards, the current time of all simulations is the
+   * target time.
+   *
+   * @param target Target time.
+   */
+  void run_until(Time target) { run_windows(target); }
+
+private:
+  /// Reusable barrier for a fixed number of threads.
+  class barrier {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param n Number of threads.
+     */
+    explicit barrier(std::size_t n) : n_{n} {}
+
+    /**
+     * Wait until all threads arrived. The last arriving thread calls the
+     * completion before any thread continues.
+     *
+     * @tparam Completion Type of the completion.
+     * @param completion Callable.
+     */
+    template <typename Completion>
+    void arrive_and_wait(Completion &completion) {
+      std::unique_lock lock{mutex_};
+      auto generation = generation_;
+
+      if (++arrived_ == n_) {
+        completion();
+        arrived_ = 0;
+        ++generation_;
+        cv_.notify_all();
+        return;
+      }
+
+      cv_.wait(lock, [&] { return generation_ != generation; });
+    }
+
+  private:
+    /// Number of threads.
+    std::size_t n_;
+
+    /// Number of threads which arrived in the current generation.
+    std::size_t arrived_ = 0;
+
+    /// Number of completed generations.
+    std::size_t generation_ = 0;
+
+    /// Mutex protecting the state.
+    std::mutex mutex_;
+
+    /// Condition variable signalled when a generation completes.
+    std::condition_variable cv_;
+  };
+
+  /**
+   * Run the simulations window by window.
+   *
+   * @param target Target time, or no value to run until no more events are
+   * scheduled.
+   */
+  void run_windows(std::optional<Time> target) {
+    if (sims_.empty()) {
+      return;
+    }
+
+    // End of the current window, or no value to run without synchronization.
+    std::optional<Time> window_end;
+    bool done = false;
+
+    // Only called while no simulation runs.
+    auto next_window = [&] {
+      for (auto &ch : channels_) {
+        ch->deliver();
+      }
+
+      std::optional<Time> start;
+      for (auto &sim : sims_) {
+        if (!sim->empty() && (!start || sim->next_time() < *start)) {
+          start = sim->next_time();
+        }
+      }
+
+      window_end = target;
+      if (!start || (target && *start >= *target)) {
+        done = true;
+        return;
+      }
+
+      if (lookahead_ && (!target || *start + *lookahead_ < *target)) {
+        window_end = *start + *lookahead_;
+      }
+    };
+
+    barrier sync{sims_.size()};
+    auto work = [&](std::size_t i) {
+      auto &sim = *sims_[i];
+
+      while (!done) {
+        if (window_end) {
+          sim.run_until(*window_end);
+        } else {
+          sim.run();
+        }
+
+        sync.arrive_and_wait(next_window);
+      }
+
+      if (target) {
+        sim.run_until(*target);
+      }
+    };
+
+    next_window();
+
+    std::vector<std::thread> threads;
+    threads.reserve(sims_.size() - 1);
+    for (std::size_t i = 1; i < sims_.size(); ++i) {
+      threads.emplace_back(work, i);
+    }
+
+    work(0);
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  /// Simulations of the logical processes.
+  std::vector<std::unique_ptr<simulation_type>> sims_;
+
+  /**
+   * Channels between the logical processes. Destroyed before the
+   * simulations, since they hold events of them.
+   */
+  std::vector<std::unique_ptr<basic_channel<Time>>> channels_;
+
+  /// Smallest lookahead of all channels, or no value without channels.
+  std::optional<Time> lookahead_;
+};
+} // namespace simcpp20
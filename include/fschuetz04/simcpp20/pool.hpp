@@ -0,0 +1,252 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <array>   // std::array
+#include <cassert> // assert
+#include <cstddef> // std::size_t, std::max_align_t
+#include <new>     // ::operator new, ::operator delete
+#include <vector>  // std::vector
+
+#include "memory.hpp"
+
+namespace simcpp20 {
+/**
+ * Memory pool handing out blocks from per-size-class free lists.
+ *
+ * Blocks are carved from large chunks, which are only released in bulk when
+ * the pool is destroyed. Requests larger than the largest size class are
+ * forwarded to the global allocator. The pool is not thread-safe and is meant
+ * to be owned by a single simulation.
+ *
+ * Live blocks and bytes are counted per memory_kind, which only adds a few
+ * additions to each allocation.
+ */
+class pool {
+public:
+  /// Constructor.
+  pool() = default;
+
+  /// Destructor. Releases all chunks.
+  ~pool() {
+    for (auto chunk : chunks_) {
+      ::operator delete(chunk);
+    }
+  }
+
+  pool(const pool &) = delete;
+  pool &operator=(const pool &) = delete;
+
+  /**
+   * @param size Size of the block in bytes.
+   * @param kind Kind of the memory, used for accounting.
+   * @return Pointer to a block of at least the given size, suitably aligned
+   * for any fundamental type.
+   */
+  void *allocate(std::size_t size, memory_kind kind = memory_kind::other) {
+    auto &usage = usage_[static_cast<std::size_t>(kind)];
+    ++usage.n_blocks_;
+    usage.bytes_ += size;
+    if (usage.bytes_ > usage.peak_bytes_) {
+      usage.peak_bytes_ = usage.bytes_;
+    }
+
+    if (size > max_size) {
+      large_bytes_ += size;
+      return ::operator new(size);
+    }
+
+    auto cls = size_class(size);
+    if (auto head = free_[cls]) {
+      free_[cls] = head->next_;
+      return head;
+    }
+
+    auto block_size = (cls + 1) * granularity;
+    if (static_cast<std::size_t>(end_ - cur_) < block_size) {
+      grow();
+    }
+
+    auto ptr = cur_;
+    cur_ += block_size;
+    return ptr;
+  }
+
+  /**
+   * @param ptr Pointer to a block previously returned by allocate.
+   * @param size Size passed to allocate when the block was requested.
+   * @param kind Kind passed to allocate when the block was requested.
+   */
+  void deallocate(void *ptr, std::size_t size,
+                  memory_kind kind = memory_kind::other) noexcept {
+    assert(ptr);
+
+    auto &usage = usage_[static_cast<std::size_t>(kind)];
+    assert(usage.n_blocks_ > 0 && usage.bytes_ >= size);
+    --usage.n_blocks_;
+    usage.bytes_ -= size;
+
+    if (size > max_size) {
+      large_bytes_ -= size;
+      ::operator delete(ptr);
+      return;
+    }
+
+    auto cls = size_class(size);
+    auto head = static_cast<free_block *>(ptr);
+    head->next_ = free_[cls];
+    free_[cls] = head;
+  }
+
+  /**
+   * @param kind Kind of memory.
+   * @return Live memory of the given kind.
+   */
+  const memory_usage &usage(memory_kind kind) const {
+    return usage_[static_cast<std::size_t>(kind)];
+  }
+
+  /**
+   * @return Number of bytes held by the pool: its chunks, whether in use or
+   * free, and the live blocks forwarded to the global allocator.
+   */
+  std::size_t reserved_bytes() const { return chunk_bytes_ + large_bytes_; }
+
+  /// Granularity and alignment of all blocks handed out by the pool.
+  static constexpr std::size_t granularity = alignof(std::max_align_t);
+
+  /// Largest block size served from the free lists.
+  static constexpr std::size_t max_size = 64 * granularity;
+
+private:
+  /// Node of a free list.
+  struct free_block {
+    /// Next free block of the same size class.
+    free_block *next_;
+  };
+
+  /**
+   * @param size Size of a block in bytes.
+   * @return Index of the size class serving the given size.
+   */
+  static constexpr std::size_t size_class(std::size_t size) {
+    return size == 0 ? 0 : (size - 1) / granularity;
+  }
+
+  /// Allocate a new chunk to carve blocks from.
+  void grow() {
+    if (chunk_size_ < max_chunk_size) {
+      chunk_size_ *= 2;
+    }
+
+    cur_ = static_cast<std::byte *>(::operator new(chunk_size_));
+    end_ = cur_ + chunk_size_;
+    chunks_.push_back(cur_);
+    chunk_bytes_ += chunk_size_;
+  }
+
+  /// Largest size of a single chunk in bytes.
+  static constexpr std::size_t max_chunk_size = std::size_t{1} << 20;
+
+  static_assert(sizeof(free_block) <= granularity);
+
+  /// Free lists, one per size class.
+  std::array<free_block *, max_size / granularity> free_ = {};
+
+  /// Chunks allocated by the pool.
+  std::vector<std::byte *> chunks_ = {};
+
+  /// Start of the unused part of the current chunk.
+  std::byte *cur_ = nullptr;
+
+  /// End of the current chunk.
+  std::byte *end_ = nullptr;
+
+  /// Size of the most recently allocated chunk in bytes.
+  std::size_t chunk_size_ = std::size_t{1} << 11;
+
+  /// Total size of all chunks in bytes.
+  std::size_t chunk_bytes_ = 0;
+
+  /// Total size of the live blocks forwarded to the global allocator.
+  std::size_t large_bytes_ = 0;
+
+  /// Live memory per kind.
+  std::array<memory_usage, n_memory_kinds> usage_ = {};
+};
+
+/**
+ * Standard allocator backed by a pool. The kind of memory is part of the type,
+ * so the allocator is a single pointer and can be embedded in small
+ * containers cheaply.
+ *
+ * @tparam T Type of the allocated objects.
+ * @tparam Kind Kind of the allocated memory, used for accounting.
+ */
+template <typename T, memory_kind Kind = memory_kind::other>
+class pool_allocator {
+public:
+  using value_type = T;
+
+  /**
+   * Allocator of another type with the same kind of memory.
+   *
+   * @tparam U Type of the objects allocated by the other allocator.
+   */
+  template <typename U> struct rebind {
+    /// Type of the other allocator.
+    using other = pool_allocator<U, Kind>;
+  };
+
+  /**
+   * Constructor.
+   *
+   * @param p Reference to the pool.
+   */
+  explicit pool_allocator(pool &p) noexcept : pool_{&p} {}
+
+  /**
+   * Converting constructor.
+   *
+   * @tparam U Type of the objects allocated by the other allocator.
+   * @param other Allocator to copy the pool from.
+   */
+  template <typename U>
+  pool_allocator(const pool_allocator<U, Kind> &other) noexcept
+      : pool_{other.pool_} {}
+
+  /**
+   * @param n Number of objects.
+   * @return Pointer to uninitialized storage for n objects.
+   */
+  T *allocate(std::size_t n) {
+    static_assert(alignof(T) <= pool::granularity);
+    return static_cast<T *>(pool_->allocate(n * sizeof(T), Kind));
+  }
+
+  /**
+   * @param ptr Pointer previously returned by allocate.
+   * @param n Number of objects passed to allocate.
+   */
+  void deallocate(T *ptr, std::size_t n) noexcept {
+    pool_->deallocate(ptr, n * sizeof(T), Kind);
+  }
+
+  /**
+   * @tparam U Type of the objects allocated by the other allocator.
+   * @param other Other allocator.
+   * @return Whether both allocators use the same pool.
+   */
+  template <typename U>
+  bool operator==(const pool_allocator<U, Kind> &other) const noexcept {
+    return pool_ == other.pool_;
+  }
+
+private:
+  /// Pool to allocate from.
+  pool *pool_;
+
+  template <typename U, memory_kind> friend class pool_allocator;
+};
+} // namespace simcpp20
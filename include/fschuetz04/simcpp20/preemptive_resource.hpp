@@ -0,0 +1,95 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cstdint> // std::uint64_t
+
+#include "resource.hpp"
+#include "simulation.hpp"
+
+namespace simcpp20 {
+/**
+ * Priority resource whose units can be taken away from users by requests
+ * with a lower priority value.
+ *
+ * If no unit is available, a preempting request takes the unit of the user
+ * with the highest priority value, and of those the one granted last, if its
+ * priority value is higher than the one of the request. The preempted user is
+ * notified through the event returned by preempted.
+ *
+ * Since the resource tracks its users, a request must stay alive while its
+ * unit is used, and the unit is released with release on the request or when
+ * the request is destroyed:
+ *
+ *     auto req = res.request(priority);
+ *     co_await req;
+ *     co_await (sim.timeout(service_time) | res.preempted(req));
+ *     res.release(req);
+ *
+ * @tparam Simulation Type of the simulation.
+ */
+template <typename Simulation>
+class basic_preemptive_resource : public basic_resource<Simulation> {
+  using base = basic_resource<Simulation>;
+
+public:
+  /// Type of the requests.
+  using typename base::request_type;
+
+  /// Type of the events of the simulation.
+  using typename base::event_type;
+
+  /**
+   * Constructor.
+   *
+   * @param sim Reference to the simulation.
+   * @param capacity Number of units.
+   */
+  basic_preemptive_resource(Simulation &sim, std::uint64_t capacity)
+      : base{sim, capacity, true} {}
+
+  /**
+   * @param priority Priority of the request. Lower values are served first.
+   * @param preempt Whether the request may preempt users.
+   * @return Request for one unit.
+   */
+  request_type request(int priority = 0, bool preempt = true) {
+    return this->make_request(priority, preempt);
+  }
+
+  /**
+   * Release the unit used by a request. Does nothing if the request was
+   * preempted or did not get a unit.
+   *
+   * @param req Request.
+   */
+  void release(request_type &req) { base::release(req); }
+
+  /**
+   * @param req Request.
+   * @return Whether the unit of the request was taken away.
+   */
+  bool is_preempted(const request_type &req) const {
+    return base::is_preempted(req);
+  }
+
+  /**
+   * @param req Request.
+   * @return Event which is triggered when the unit of the request is taken
+   * away.
+   */
+  event_type preempted(request_type &req) { return base::preempted_event(req); }
+};
+
+/// @tparam Time Type used for simulation time.
+template <typename Time = double>
+using preemptive_resource = basic_preemptive_resource<simulation<Time>>;
+
+#ifdef FSCHUETZ04_SIMCPP20_EXTERN_TEMPLATES
+// Explicitly instantiated in src/simcpp20.cpp.
+extern template class basic_preemptive_resource<simulation<double>>;
+
+extern template class basic_preemptive_resource<simulation<std::uint64_t>>;
+#endif
+} // namespace simcpp20
@@ -0,0 +1,57 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cstdint> // std::uint64_t
+
+#include "resource.hpp"
+#include "simulation.hpp"
+
+namespace simcpp20 {
+/**
+ * Resource with a fixed number of units which are handed to waiting requests
+ * in order of their priority. Requests with the same priority are served in
+ * FIFO order.
+ *
+ * Inserting a request passes all waiting requests with a higher priority
+ * value, so requests of the same or increasing priority values are inserted
+ * in O(1). Removing a request is always O(1).
+ *
+ * @tparam Simulation Type of the simulation.
+ */
+template <typename Simulation>
+class basic_priority_resource : public basic_resource<Simulation> {
+public:
+  /// Type of the requests.
+  using typename basic_resource<Simulation>::request_type;
+
+  /**
+   * Constructor.
+   *
+   * @param sim Reference to the simulation.
+   * @param capacity Number of units.
+   */
+  basic_priority_resource(Simulation &sim, std::uint64_t capacity)
+      : basic_resource<Simulation>{sim, capacity} {}
+
+  /**
+   * @param priority Priority of the request. Lower values are served first.
+   * @return Request for one unit.
+   */
+  request_type request(int priority = 0) {
+    return this->make_request(priority, false);
+  }
+};
+
+/// @tparam Time Type used for simulation time.
+template <typename Time = double>
+using priority_resource = basic_priority_resource<simulation<Time>>;
+
+#ifdef FSCHUETZ04_SIMCPP20_EXTERN_TEMPLATES
+// Explicitly instantiated in src/simcpp20.cpp.
+extern template class basic_priority_resource<simulation<double>>;
+
+extern template class basic_priority_resource<simulation<std::uint64_t>>;
+#endif
+} // namespace simcpp20
@@ -0,0 +1,305 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm>   // std::sort, std::upper_bound
+#include <array>       // std::array
+#include <bit>         // std::bit_width, std::countr_zero
+#include <cassert>     // assert
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint64_t
+#include <limits>      // std::numeric_limits
+#include <type_traits> // std::conditional_t, std::is_integral_v,
+                       // std::is_signed_v, std::make_unsigned_t
+#include <utility>     // std::move, std::swap
+#include <vector>      // std::erase_if, std::vector
+
+#include "heap.hpp"
+
+namespace simcpp20 {
+/**
+ * Queue of scheduled events implemented as a radix heap (R. Ahuja, K.
+ * Mehlhorn, J. Orlin and R. Tarjan, 1990) for integral time.
+ *
+ * The time of the last popped item is remembered. Each item is kept in the
+ * bucket given by the highest bit in which its time differs from that time,
+ * so bucket 0 holds the items at that time. When bucket 0 is empty, the
+ * earliest item is in the smallest non-empty bucket, and popping it
+ * redistributes that bucket relative to its time. Each item moves to a lower
+ * bucket at most once per bit, which gives O(1) push and O(log C) amortized
+ * pop, where C is the largest delay.
+ *
+ * Items at the same time are popped in the order given by their
+ * greater-than operator, like with the other queues. Times must not be
+ * negative, which holds for the simulation.
+ *
+ * Items are usually pushed at or after the time of the last popped item. The
+ * simulation may pop a discarded item scheduled after the current time,
+ * though, and then push items before it. Such items are kept in a binary heap
+ * which is popped before the buckets, since all items in the buckets are at
+ * or after the time of the last popped item.
+ *
+ * @tparam Item Type of the queued items.
+ */
+template <typename Item> class radix_heap {
+  /// Unsigned type of the time of the items.
+  using key_type = std::make_unsigned_t<decltype(Item::time_)>;
+
+public:
+  /// @return Whether the queue is empty.
+  bool empty() const { return size_ == 0; }
+
+  /// @return Number of queued items.
+  std::size_t size() const { return size_; }
+
+  /// @return First item of the queue.
+  const Item &top() const {
+    assert(!empty());
+
+    if (!early_.empty()) {
+      return early_.top();
+    }
+
+    if (head_ < buckets_[0].size()) {
+      return buckets_[0][head_];
+    }
+
+    find_min();
+    return buckets_[min_bucket_][min_index_];
+  }
+
+  /// @param item Item to insert.
+  void push(Item item) {
+    ++size_;
+    if (key(item) < last_) [[unlikely]] {
+      early_.push(std::move(item));
+      return;
+    }
+
+    auto i = bucket(item);
+    if (i == 0) {
+      // Keep the items of bucket 0 in order. Remove the popped items first,
+      // which are moved-from and must not be moved again if the bucket grows.
+      auto &first = buckets_[0];
+      first.erase(first.begin(), first.begin() + head_);
+      head_ = 0;
+      auto pos = std::upper_bound(first.begin(), first.end(), item, before);
+      first.insert(pos, std::move(item));
+    } else {
+      auto &bucket = buckets_[i];
+      bucket.push_back(std::move(item));
+      non_empty_ |= mask(i);
+
+      if (min_bucket_ != 0 &&
+          (i < min_bucket_ ||
+           (i == min_bucket_ && before(bucket.back(), bucket[min_index_])))) {
+        min_bucket_ = i;
+        min_index_ = bucket.size() - 1;
+      }
+    }
+  }
+
+  /**
+   * Insert many items. Inserting each item already takes O(1).
+   *
+   * @param items Items to insert.
+   */
+  void push_many(std::vector<Item> items) {
+    for (auto &item : items) {
+      push(std::move(item));
+    }
+  }
+
+  /**
+   * Remove the first item of the queue.
+   *
+   * @return Removed item.
+   */
+  Item pop() {
+    assert(!empty());
+
+    --size_;
+    if (!early_.empty()) {
+      return early_.pop();
+    }
+
+    if (head_ == buckets_[0].size()) {
+      redistribute();
+    }
+
+    auto &first = buckets_[0];
+    auto item = std::move(first[head_]);
+    ++head_;
+    if (head_ == first.size()) {
+      first.clear();
+      head_ = 0;
+    }
+
+    return item;
+  }
+
+  /**
+   * Remove all items matching a predicate in O(n).
+   *
+   * @tparam Predicate Type of the predicate.
+   * @param pred Predicate called with each item.
+   * @return Number of removed items.
+   */
+  template <typename Predicate> std::size_t erase_if(Predicate pred) {
+    auto &first = buckets_[0];
+    first.erase(first.begin(), first.begin() + head_);
+    head_ = 0;
+
+    auto n = early_.erase_if(pred);
+    non_empty_ = 0;
+    for (std::size_t i = 0; i < n_buckets; ++i) {
+      n += std::erase_if(buckets_[i], pred);
+      if (i > 0 && !buckets_[i].empty()) {
+        non_empty_ |= mask(i);
+      }
+    }
+
+    size_ -= n;
+    min_bucket_ = 0;
+    return n;
+  }
+
+private:
+  /**
+   * @param a Item.
+   * @param b Other item.
+   * @return Whether the item is ordered before the other item.
+   */
+  static bool before(const Item &a, const Item &b) { return b > a; }
+
+  /**
+   * @param item Item.
+   * @return Time of the item as an unsigned key.
+   */
+  static key_type key(const Item &item) {
+    if constexpr (std::is_signed_v<decltype(Item::time_)>) {
+      assert(item.time_ >= 0);
+    }
+
+    return static_cast<key_type>(item.time_);
+  }
+
+  /**
+   * @param item Item.
+   * @return Index of the bucket of the item relative to the time of the last
+   * popped item.
+   */
+  std::size_t bucket(const Item &item) const {
+    assert(key(item) >= last_);
+    return static_cast<std::size_t>(std::bit_width(key(item) ^ last_));
+  }
+
+  /**
+   * Find the earliest item while bucket 0 is empty, unless it is already
+   * known. It is in the smallest non-empty bucket.
+   */
+  void find_min() const {
+    if (min_bucket_ != 0) {
+      return;
+    }
+
+    assert(non_empty_ != 0);
+    auto i = static_cast<std::size_t>(std::countr_zero(non_empty_)) + 1;
+
+    auto &bucket = buckets_[i];
+    std::size_t min = 0;
+    for (std::size_t j = 1; j < bucket.size(); ++j) {
+      if (before(bucket[j], bucket[min])) {
+        min = j;
+      }
+    }
+
+    min_bucket_ = i;
+    min_index_ = min;
+  }
+
+  /**
+   * Redistribute the bucket of the earliest item relative to its time while
+   * bucket 0 is empty, which moves at least that item into bucket 0.
+   */
+  void redistribute() {
+    find_min();
+
+    // Swap instead of move, so that both vectors keep their capacity.
+    std::swap(scratch_, buckets_[min_bucket_]);
+    non_empty_ &= ~mask(min_bucket_);
+    last_ = key(scratch_[min_index_]);
+    min_bucket_ = 0;
+
+    for (auto &item : scratch_) {
+      auto i = bucket(item);
+      buckets_[i].push_back(std::move(item));
+      if (i > 0) {
+        non_empty_ |= mask(i);
+      }
+    }
+    scratch_.clear();
+
+    auto &first = buckets_[0];
+    if (first.size() > 1) {
+      std::sort(first.begin(), first.end(), before);
+    }
+  }
+
+  /**
+   * @param i Index of a bucket other than bucket 0.
+   * @return Bit of the bucket in non_empty_.
+   */
+  static constexpr std::uint64_t mask(std::size_t i) {
+    return std::uint64_t{1} << (i - 1);
+  }
+
+  /// Number of buckets. Bucket i holds the items differing in bit i - 1.
+  static constexpr std::size_t n_buckets =
+      std::numeric_limits<key_type>::digits + 1;
+
+  static_assert(n_buckets - 1 <= 64);
+
+  /// Buckets of items, see bucket.
+  std::array<std::vector<Item>, n_buckets> buckets_;
+
+  /// Items before the time of the last popped item.
+  binary_heap<Item> early_;
+
+  /// Empty vector swapped with the bucket which is redistributed.
+  std::vector<Item> scratch_;
+
+  /// Bit i - 1 is set if bucket i is not empty, for all buckets but bucket 0.
+  std::uint64_t non_empty_ = 0;
+
+  /// Index of the first item of bucket 0. The items before it were popped.
+  std::size_t head_ = 0;
+
+  /// Number of queued items.
+  std::size_t size_ = 0;
+
+  /// Time of the last popped item.
+  key_type last_ = 0;
+
+  /**
+   * Bucket of the earliest item while bucket 0 is empty, or 0 if it is not
+   * known.
+   */
+  mutable std::size_t min_bucket_ = 0;
+
+  /// Index of the earliest item in its bucket, if its bucket is known.
+  mutable std::size_t min_index_ = 0;
+};
+
+/**
+ * Queue used by a simulation unless another one is selected: a radix heap if
+ * the time is integral, and a binary heap otherwise.
+ *
+ * @tparam Item Type of the queued items.
+ */
+template <typename Item>
+using default_queue =
+    std::conditional_t<std::is_integral_v<decltype(Item::time_)>,
+                       radix_heap<Item>, binary_heap<Item>>;
+} // namespace simcpp20
@@ -0,0 +1,361 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <array>   // std::array
+#include <bit>     // std::bit_cast
+#include <cmath>   // std::log, std::sqrt
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint32_t, std::uint64_t
+#include <limits>  // std::numeric_limits
+
+namespace simcpp20 {
+/**
+ * Counter-based random number engine Philox4x32-10 by Salmon et al. Each
+ * block of four 32-bit outputs is a pure function of the seed, the stream
+ * and the position of the block, so independent streams are created in O(1)
+ * and blocks can be generated independently of each other.
+ *
+ * Satisfies the requirements of a uniform random bit generator, so it can be
+ * used with the distributions of the standard library.
+ */
+class philox {
+public:
+  using result_type = std::uint64_t;
+
+  /// Block of four 32-bit values.
+  using block_type = std::array<std::uint32_t, 4>;
+
+  /// Key of two 32-bit values.
+  using key_type = std::array<std::uint32_t, 2>;
+
+  /**
+   * Constructor.
+   *
+   * @param seed Seed, used as the key.
+   * @param stream ID of the stream.
+   */
+  explicit philox(std::uint64_t seed = 0, std::uint64_t stream = 0)
+      : key_{static_cast<std::uint32_t>(seed),
+             static_cast<std::uint32_t>(seed >> 32)},
+        stream_{stream} {}
+
+  /// @return Smallest value returned.
+  static constexpr result_type min() { return 0; }
+
+  /// @return Largest value returned.
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  /// @return Next value of the stream.
+  result_type operator()() {
+    if (next_ == outputs_.size()) {
+      auto out = block(position_++);
+      outputs_ = {join(out[0], out[1]), join(out[2], out[3])};
+      next_ = 0;
+    }
+
+    return outputs_[next_++];
+  }
+
+  /**
+   * Fill a range with the next values of the stream. Whole blocks are
+   * generated in a loop without dependencies between its iterations, which
+   * the processor can overlap.
+   *
+   * @param first Pointer to the first value to fill.
+   * @param n Number of values to fill.
+   */
+  void generate(result_type *first, std::size_t n) {
+    for (; n > 0 && next_ < outputs_.size(); --n) {
+      *first++ = outputs_[next_++];
+    }
+
+    auto n_blocks = n / 2;
+    for (std::size_t i = 0; i < n_blocks; ++i) {
+      auto out = block(position_ + i);
+      first[2 * i] = join(out[0], out[1]);
+      first[2 * i + 1] = join(out[2], out[3]);
+    }
+
+    position_ += n_blocks;
+
+    if (n % 2 == 1) {
+      first[n - 1] = (*this)();
+    }
+  }
+
+  /// @param n Number of values to skip.
+  void discard(std::uint64_t n) {
+    for (; n > 0 && next_ < outputs_.size(); --n) {
+      ++next_;
+    }
+
+    position_ += n / 2;
+    if (n % 2 == 1) {
+      (*this)();
+    }
+  }
+
+  /**
+   * @param id ID of the substream.
+   * @return Engine with the same seed and a stream derived from the stream of
+   * this engine and the given ID, for example the stream of one process
+   * within the stream of one replication. Does not depend on the position of
+   * this engine.
+   */
+  philox substream(std::uint64_t id) const {
+    // Hash the pair of stream IDs with one block under a different key.
+    auto out = apply({static_cast<std::uint32_t>(id),
+                      static_cast<std::uint32_t>(id >> 32),
+                      static_cast<std::uint32_t>(stream_),
+                      static_cast<std::uint32_t>(stream_ >> 32)},
+                     {key_[0] ^ 0x5851F42Du, key_[1] ^ 0x4C957F2Du});
+    philox engine;
+    engine.key_ = key_;
+    engine.stream_ = join(out[0], out[1]);
+    return engine;
+  }
+
+  /**
+   * Apply the Philox4x32-10 bijection.
+   *
+   * @param ctr Counter.
+   * @param key Key.
+   * @return Output block.
+   */
+  static constexpr block_type apply(block_type ctr, key_type key) {
+    for (int round = 0; round < 10; ++round) {
+      auto p0 = std::uint64_t{0xD2511F53u} * ctr[0];
+      auto p1 = std::uint64_t{0xCD9E8D57u} * ctr[2];
+      ctr = {static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0],
+             static_cast<std::uint32_t>(p1),
+             static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1],
+             static_cast<std::uint32_t>(p0)};
+      key[0] += 0x9E3779B9u;
+      key[1] += 0xBB67AE85u;
+    }
+
+    return ctr;
+  }
+
+private:
+  /**
+   * @param position Position of the block within the stream.
+   * @return Block at the given position.
+   */
+  block_type block(std::uint64_t position) const {
+    return apply({static_cast<std::uint32_t>(position),
+                  static_cast<std::uint32_t>(position >> 32),
+                  static_cast<std::uint32_t>(stream_),
+                  static_cast<std::uint32_t>(stream_ >> 32)},
+                 key_);
+  }
+
+  /**
+   * @param lo Lower 32 bits.
+   * @param hi Upper 32 bits.
+   * @return Combined 64-bit value.
+   */
+  static constexpr std::uint64_t join(std::uint32_t lo, std::uint32_t hi) {
+    return std::uint64_t{hi} << 32 | lo;
+  }
+
+  /// Key derived from the seed.
+  key_type key_;
+
+  /// ID of the stream.
+  std::uint64_t stream_;
+
+  /// Position of the next block within the stream.
+  std::uint64_t position_ = 0;
+
+  /// Values of the current block.
+  std::array<result_type, 2> outputs_ = {};
+
+  /// Index of the next value of the current block.
+  std::size_t next_ = outputs_.size();
+};
+
+/**
+ * Stream of random variates, meant to be owned by one process or one source
+ * of randomness of a model, so its variates do not depend on the order in
+ * which processes run:
+ *
+ *     simcpp20::random_stream root{seed};
+ *     auto rng = root.substream(replication).substream(machine_id);
+ *     co_await sim.timeout(rng.exponential(1. / 300));
+ *
+ * Uniform, exponential and normal variates are generated in batches into
+ * small buffers. The random bits of a batch are generated in one loop, and
+ * the transformations run in tight loops the compiler may vectorize, for
+ * example the logarithms of exponential variates with -ffast-math. Each kind
+ * of variate is drawn from its own substream, so the variates of one kind do
+ * not depend on how many variates of other kinds were drawn.
+ */
+class random_stream {
+public:
+  /// Number of variates generated at once for each kind.
+  static constexpr std::size_t batch_size = 32;
+
+  /**
+   * Constructor.
+   *
+   * @param seed Seed, for example of the whole experiment.
+   * @param stream ID of the stream.
+   */
+  explicit random_stream(std::uint64_t seed, std::uint64_t stream = 0)
+      : random_stream{philox{seed, stream}} {}
+
+  /**
+   * @param id ID of the substream, for example of a replication or process.
+   * @return Independent stream derived from this stream and the ID. Does not
+   * depend on the variates drawn from this stream.
+   */
+  random_stream substream(std::uint64_t id) const {
+    return random_stream{root_.substream(id)};
+  }
+
+  /// @return Uniform variate in [0, 1).
+  double uniform() {
+    if (uniforms_.next_ == batch_size) {
+      fill_uniforms(uniforms_);
+    }
+
+    return uniforms_.values_[uniforms_.next_++];
+  }
+
+  /**
+   * @param a Lower bound.
+   * @param b Upper bound.
+   * @return Uniform variate in [a, b).
+   */
+  double uniform(double a, double b) { return a + (b - a) * uniform(); }
+
+  /**
+   * @param rate Rate, the inverse of the mean. Must be positive.
+   * @return Exponentially distributed variate.
+   */
+  double exponential(double rate) {
+    if (exponentials_.next_ == batch_size) {
+      fill_exponentials();
+    }
+
+    return exponentials_.values_[exponentials_.next_++] / rate;
+  }
+
+  /**
+   * @param mean Mean.
+   * @param stddev Standard deviation.
+   * @return Normally distributed variate.
+   */
+  double normal(double mean = 0, double stddev = 1) {
+    if (normals_.next_ == batch_size) {
+      fill_normals();
+    }
+
+    return mean + stddev * normals_.values_[normals_.next_++];
+  }
+
+  /**
+   * @return Engine for raw random bits, for example to be used with the
+   * distributions of the standard library. Independent of the buffered
+   * variates.
+   */
+  philox &engine() { return bits_; }
+
+private:
+  /// Buffered variates of one kind.
+  struct buffer {
+    /// Engine the variates are generated from.
+    philox engine_;
+
+    /// Variates.
+    std::array<double, batch_size> values_ = {};
+
+    /// Index of the next variate.
+    std::size_t next_ = batch_size;
+  };
+
+  /// @param root Engine of the stream.
+  explicit random_stream(philox root)
+      : root_{root}, bits_{root.substream(0)},
+        uniforms_{root.substream(1)}, exponentials_{root.substream(2)},
+        normals_{root.substream(3)} {}
+
+  /**
+   * Fill a buffer with uniform variates in [0, 1).
+   *
+   * @param buf Buffer to fill.
+   */
+  static void fill_uniforms(buffer &buf) {
+    std::array<std::uint64_t, batch_size> bits;
+    buf.engine_.generate(bits.data(), batch_size);
+    for (std::size_t i = 0; i < batch_size; ++i) {
+      buf.values_[i] = to_unit(bits[i]);
+    }
+
+    buf.next_ = 0;
+  }
+
+  /// Fill the buffer of standard exponential variates.
+  void fill_exponentials() {
+    fill_uniforms(exponentials_);
+    for (auto &value : exponentials_.values_) {
+      value = -std::log(1 - value);
+    }
+  }
+
+  /// Fill the buffer of standard normal variates with the polar method.
+  void fill_normals() {
+    std::array<std::uint64_t, 2 * batch_size> bits;
+    auto next = bits.size();
+    auto &values = normals_.values_;
+    for (std::size_t i = 0; i < batch_size; i += 2) {
+      double u, v, s;
+      do {
+        if (next == bits.size()) {
+          normals_.engine_.generate(bits.data(), bits.size());
+          next = 0;
+        }
+
+        u = 2 * to_unit(bits[next++]) - 1;
+        v = 2 * to_unit(bits[next++]) - 1;
+        s = u * u + v * v;
+      } while (s >= 1 || s == 0);
+
+      auto factor = std::sqrt(-2 * std::log(s) / s);
+      values[i] = u * factor;
+      values[i + 1] = v * factor;
+    }
+
+    normals_.next_ = 0;
+  }
+
+  /**
+   * @param bits Random bits.
+   * @return Uniform variate in [0, 1) formed from the upper 52 bits, which
+   * become the mantissa of a double in [1, 2).
+   */
+  static double to_unit(std::uint64_t bits) {
+    return std::bit_cast<double>(bits >> 12 | 0x3FF0000000000000u) - 1;
+  }
+
+  /// Engine of the stream, used to derive substreams.
+  philox root_;
+
+  /// Engine for raw random bits.
+  philox bits_;
+
+  /// Buffered uniform variates.
+  buffer uniforms_;
+
+  /// Buffered standard exponential variates.
+  buffer exponentials_;
+
+  /// Buffered standard normal variates.
+  buffer normals_;
+};
+} // namespace simcpp20
@@ -0,0 +1,183 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert> // assert
+#include <chrono>  // std::chrono
+#include <thread>  // std::this_thread
+
+#include "simulation.hpp"
+
+namespace simcpp20 {
+/**
+ * Run a simulation in real time, for example when it is coupled to hardware
+ * or to a live system:
+ *
+ *     simcpp20::realtime<> rt{sim, 0.5};
+ *     rt.run_until(60);
+ *
+ * Each event is processed once the wall-clock time corresponding to its time
+ * is reached. The simulation time passed since the runner was created (or
+ * synchronized) multiplied by the factor is the wall-clock time in seconds
+ * passed since then. The clock is only read when the simulation time
+ * advances, not for every event.
+ *
+ * To wake up on time, the runner sleeps until shortly before the deadline and
+ * then spins, yielding to other threads, for the remaining time. The lag is
+ * how late an event was processed compared to its deadline, either because
+ * of the remaining jitter or because the simulation cannot keep up.
+ *
+ * @tparam Simulation Type of the simulation.
+ */
+template <typename Simulation> class basic_realtime {
+public:
+  /// Type used for simulation time.
+  using time_type = typename Simulation::time_type;
+
+  /// Clock used for the wall-clock time.
+  using clock = std::chrono::steady_clock;
+
+  /**
+   * Constructor. The current simulation time corresponds to the current
+   * wall-clock time.
+   *
+   * @param sim Reference to the simulation.
+   * @param factor Wall-clock seconds per unit of simulation time. Must be
+   * positive.
+   * @param spin Time before a deadline from which on the runner spins instead
+   * of sleeping.
+   */
+  explicit basic_realtime(Simulation &sim, double factor = 1,
+                          clock::duration spin = std::chrono::microseconds{200})
+      : sim_{&sim}, factor_{factor}, spin_{spin} {
+    assert(factor > 0);
+    sync();
+  }
+
+  /**
+   * Let the current simulation time correspond to the current wall-clock
+   * time, for example after the simulation was paused.
+   */
+  void sync() {
+    sim_start_ = sim_->now();
+    wall_start_ = clock::now();
+    reached_ = sim_start_;
+  }
+
+  /// Wait until the next event is due and process it.
+  void step() {
+    auto time = sim_->next_time();
+    if (time != reached_) {
+      wait_until(time);
+      reached_ = time;
+    }
+
+    sim_->step();
+  }
+
+  /// Run the simulation in real time until no more events are scheduled.
+  void run() {
+    while (!sim_->empty()) {
+      step();
+    }
+  }
+
+  /**
+   * Run the simulation in real time until the target time is reached, see
+   * simulation::run_until. Returns when the wall-clock time corresponding to
+   * the target time is reached.
+   *
+   * @param target Target time.
+   */
+  void run_until(time_type target) {
+    while (!sim_->empty() && sim_->next_time() < target) {
+      step();
+    }
+
+    if (target != reached_) {
+      wait_until(target);
+      reached_ = target;
+    }
+
+    sim_->run_until(target);
+  }
+
+  /**
+   * @param time Simulation time.
+   * @return Wall-clock time corresponding to the simulation time.
+   */
+  clock::time_point deadline(time_type time) const {
+    std::chrono::duration<double> offset{
+        factor_ * static_cast<double>(time - sim_start_)};
+    return wall_start_ + std::chrono::duration_cast<clock::duration>(offset);
+  }
+
+  /// @return Lag of the last time the simulation time advanced.
+  clock::duration lag() const { return lag_; }
+
+  /// @return Largest lag since the runner was created.
+  clock::duration max_lag() const { return max_lag_; }
+
+  /// @return Wall-clock seconds per unit of simulation time.
+  double factor() const { return factor_; }
+
+private:
+  /**
+   * Wait until the wall-clock time corresponding to the given simulation time
+   * is reached and record the lag.
+   *
+   * @param time Simulation time.
+   */
+  void wait_until(time_type time) {
+    auto target = deadline(time);
+    auto now = clock::now();
+    if (target - now > spin_) {
+      std::this_thread::sleep_until(target - spin_);
+      now = clock::now();
+    }
+
+    while (now < target) {
+      std::this_thread::yield();
+      now = clock::now();
+    }
+
+    lag_ = now - target;
+    if (lag_ > max_lag_) {
+      max_lag_ = lag_;
+    }
+  }
+
+  /// Simulation to run.
+  Simulation *sim_;
+
+  /// Wall-clock seconds per unit of simulation time.
+  double factor_;
+
+  /// Time before a deadline from which on the runner spins.
+  clock::duration spin_;
+
+  /// Simulation time corresponding to wall_start_.
+  time_type sim_start_{};
+
+  /// Wall-clock time corresponding to sim_start_.
+  clock::time_point wall_start_{};
+
+  /// Latest simulation time whose wall-clock time was waited for.
+  time_type reached_{};
+
+  /// Lag of the last time the simulation time advanced.
+  clock::duration lag_{};
+
+  /// Largest lag.
+  clock::duration max_lag_{};
+};
+
+/**
+ * Real-time runner of a simulation using the default queue.
+ *
+ * @tparam Time Type used for simulation time.
+ */
+template <typename Time = double>
+using realtime = basic_realtime<simulation<Time>>;
+} // namespace simcpp20
@@ -0,0 +1,127 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm>   // std::clamp
+#include <atomic>      // std::atomic
+#include <cstddef>     // std::size_t
+#include <exception>   // std::current_exception, std::rethrow_exception
+#include <functional>  // std::invoke
+#include <mutex>       // std::lock_guard, std::mutex
+#include <optional>    // std::optional
+#include <thread>      // std::thread
+#include <type_traits> // std::invoke_result_t
+#include <utility>     // std::move
+#include <vector>      // std::vector
+
+namespace simcpp20 {
+/**
+ * Run independent replications of a model in parallel.
+ *
+ * Each replication is one call of the model with its index, which usually
+ * creates its own simulation, seeds its random number generators from the
+ * index, runs the simulation and returns the result. Simulations and their
+ * pools are self-contained, so no simulation state is shared between threads
+ * as long as the model does not share state between replications itself.
+ *
+ * Worker threads take the next replication index from a shared counter until
+ * all replications are taken, so threads finishing early take over the
+ * remaining work. If a replication throws, no further replications are
+ * started and the first exception is rethrown after all threads finished.
+ *
+ * @tparam Model Type of the model.
+ * @param n Number of replications.
+ * @param model Callable with the index of the replication, returning its
+ * result. Called concurrently from multiple threads.
+ * @param n_threads Number of threads. Defaults to the number of cores. At
+ * most n threads are used.
+ * @return Results of the replications, ordered by index.
+ */
+template <typename Model>
+auto run_replications(
+    std::size_t n, Model model,
+    std::size_t n_threads = std::thread::hardware_concurrency())
+    -> std::vector<std::invoke_result_t<Model &, std::size_t>> {
+  using result_type = std::invoke_result_t<Model &, std::size_t>;
+
+  std::vector<std::optional<result_type>> results(n);
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr exception;
+  std::mutex exception_mutex;
+
+  auto work = [&] {
+    while (!failed.load(std::memory_order_relaxed)) {
+      auto i = next.fetch_add(1, std::memory_order_relaxed);
+      if (i >= n) {
+        return;
+      }
+
+      try {
+        results[i].emplace(std::invoke(model, i));
+      } catch (...) {
+        std::lock_guard lock{exception_mutex};
+        if (!exception) {
+          exception = std::current_exception();
+        }
+        failed.store(true, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  n_threads = std::clamp<std::size_t>(n_threads, 1, n == 0 ? 1 : n);
+  std::vector<std::thread> threads;
+  threads.reserve(n_threads - 1);
+  for (std::size_t i = 1; i < n_threads; ++i) {
+    threads.emplace_back(work);
+  }
+
+  work();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+
+  std::vector<result_type> out;
+  out.reserve(n);
+  for (auto &result : results) {
+    out.push_back(std::move(*result));
+  }
+
+  return out;
+}
+
+/**
+ * Run independent replications of a model in parallel and reduce their
+ * results. The results are reduced on the calling thread in the order of
+ * their index, so the reduction is deterministic even if it is not
+ * commutative.
+ *
+ * @tparam Model Type of the model.
+ * @tparam Value Type of the reduced value.
+ * @tparam Reducer Type of the reducer.
+ * @param n Number of replications.
+ * @param model Callable with the index of the replication, returning its
+ * result. Called concurrently from multiple threads.
+ * @param init Initial value of the reduction.
+ * @param reduce Callable with the reduced value so far and the result of the
+ * next replication, returning the new reduced value.
+ * @param n_threads Number of threads. Defaults to the number of cores.
+ * @return Reduced value.
+ */
+template <typename Model, typename Value, typename Reducer>
+Value run_replications(
+    std::size_t n, Model model, Value init, Reducer reduce,
+    std::size_t n_threads = std::thread::hardware_concurrency()) {
+  auto results = run_replications(n, std::move(model), n_threads);
+  for (auto &result : results) {
+    init = std::invoke(reduce, std::move(init), std::move(result));
+  }
+
+  return init;
+}
+} // namespace simcpp20
@@ -0,0 +1,601 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert>   // assert
+#include <coroutine> // std::coroutine_handle
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint64_t
+#include <optional>  // std::optional
+
+#include "monitor.hpp"
+#include "simulation.hpp"
+
+namespace simcpp20 {
+/**
+ * Resource with a fixed number of units which are handed to waiting requests
+ * in FIFO order.
+ *
+ * Requests are awaitables which serve as nodes of an intrusive list of
+ * waiting requests. When awaited, a request lives in the coroutine frame, so
+ * waiting does not allocate, and a request which is destroyed while it waits
+ * is removed in O(1). A request which was granted, but whose coroutine was
+ * destroyed before it could use the unit, returns the unit.
+ *
+ * A request granted without waiting still suspends the coroutine, which is
+ * resumed at the current simulation time in the order of scheduling, like a
+ * process awaiting an event which is triggered when the request is made.
+ *
+ *     co_await res.request();
+ *     co_await sim.timeout(service_time);
+ *     res.release();
+ *
+ * @tparam Simulation Type of the simulation.
+ */
+template <typename Simulation> class basic_resource {
+public:
+  /// Type used for simulation time.
+  using time_type = typename Simulation::time_type;
+
+  /// Type of the events of the simulation.
+  using event_type = typename Simulation::event_type;
+
+  class request_type;
+
+  /// Awaitable waiting for a request with a timeout.
+  class timed_awaiter {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param req Request to wait for.
+     * @param timeout Time after which to stop waiting.
+     */
+    timed_awaiter(request_type &req, time_type timeout)
+        : req_{req}, timeout_{timeout} {}
+
+    /// @return Whether the request was granted before being awaited.
+    bool await_ready() const { return req_.await_ready(); }
+
+    /**
+     * Wait for the request to be granted or the timeout to pass. A request
+     * granted without waiting does not start the timeout.
+     *
+     * @tparam Promise Promise type of the coroutine.
+     * @param handle Coroutine handle.
+     */
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) const {
+      auto &req = req_;
+      if (req.state_ == request_type::state::waiting) {
+        req.timeout_ev_ = req.res_->sim_.timeout(timeout_);
+        req.timeout_ev_->add_callback([&req](const auto &) { req.expire(); });
+      }
+
+      req.await_suspend(handle);
+    }
+
+    /// @return Whether the request was granted.
+    bool await_resume() const {
+      req_.await_resume();
+      return req_.granted();
+    }
+
+  private:
+    /// Request to wait for.
+    request_type &req_;
+
+    /// Time after which to stop waiting.
+    time_type timeout_;
+  };
+
+  /// Request for one unit of a resource. Used as awaitable.
+  class request_type {
+  public:
+    /// Destructor. Cancels the request if it is still waiting.
+    ~request_type() {
+      if (timeout_ev_ && timeout_ev_->pending()) {
+        timeout_ev_->abort();
+      }
+
+      if (!res_) {
+        return;
+      }
+
+      switch (state_) {
+      case state::waiting:
+        res_->unlink(*this);
+        break;
+      case state::granted:
+        res_->give_back(*this);
+        break;
+      case state::used:
+        if (res_->preemptive_) {
+          res_->give_back(*this);
+        }
+        break;
+      default:
+        break;
+      }
+    }
+
+    request_type(const request_type &) = delete;
+    request_type &operator=(const request_type &) = delete;
+
+    /// @return Whether the request was granted.
+    bool granted() const {
+      return state_ == state::granted || state_ == state::used ||
+             state_ == state::preempted || state_ == state::released;
+    }
+
+    /**
+     * Called when using co_await on the request. Tries to acquire a unit
+     * without waiting. The coroutine is suspended even if the unit is
+     * acquired, see basic_resource.
+     *
+     * @return Whether the request was granted before being awaited.
+     */
+    bool await_ready() {
+      if (state_ != state::idle) {
+        return state_ != state::waiting;
+      }
+
+      assert(res_);
+      res_->acquire(*this);
+      return false;
+    }
+
+    /**
+     * Called when a coroutine is suspended after using co_await on the
+     * request. If the request was granted without waiting, the coroutine is
+     * scheduled to be resumed at the current simulation time.
+     *
+     * @tparam Promise Promise type of the coroutine.
+     * @param handle Coroutine handle.
+     */
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) {
+      promise_ = &handle.promise();
+      if (state_ == state::waiting) {
+        promise_->wait(this, &cancel_wait);
+      } else {
+        res_->sim_.resume(*promise_);
+      }
+    }
+
+    /**
+     * Called when the coroutine is resumed. Throws simcpp20::interrupted if
+     * the coroutine was resumed because it was interrupted.
+     */
+    void await_resume() {
+      if (promise_) {
+        promise_->sim_.check_interrupt();
+      }
+
+      if (state_ == state::granted) {
+        state_ = state::used;
+      }
+    }
+
+    /**
+     * Wait until the request is granted or the timeout passed. If the timeout
+     * passes first, the request is cancelled.
+     *
+     *     auto req = res.request();
+     *     if (co_await req.wait_for(patience)) { ... }
+     *
+     * @param timeout Time after which to stop waiting.
+     * @return Awaitable returning whether the request was granted.
+     */
+    timed_awaiter wait_for(time_type timeout) {
+      return timed_awaiter{*this, timeout};
+    }
+
+  protected:
+    /**
+     * Constructor.
+     *
+     * @param res Resource to request a unit of.
+     * @param priority Priority of the request. Lower values are served first.
+     * @param preempt Whether the request may preempt users of the resource.
+     */
+    request_type(basic_resource &res, int priority, bool preempt)
+        : res_{&res}, priority_{priority}, preempt_{preempt} {}
+
+    /// State of a request.
+    enum class state {
+      /// Not awaited yet.
+      idle,
+      /// Waiting for a unit.
+      waiting,
+      /// Granted, but the coroutine was not resumed yet.
+      granted,
+      /// Granted and the coroutine was resumed.
+      used,
+      /// Stopped waiting after the timeout passed.
+      expired,
+      /// Unit taken away by a request with a higher priority.
+      preempted,
+      /// Unit was released.
+      released,
+    };
+
+    /**
+     * Stop waiting after the timeout passed. The timeout is aborted when the
+     * request stops waiting or the resource is destroyed, so the resource
+     * still exists.
+     */
+    void expire() {
+      if (state_ != state::waiting) {
+        return;
+      }
+
+      assert(res_);
+      res_->unlink(*this);
+      state_ = state::expired;
+      promise_->end_wait();
+      res_->sim_.resume(*promise_);
+    }
+
+    /**
+     * Stop waiting because the coroutine was interrupted. The request is not
+     * waiting anymore and can be awaited again.
+     *
+     * @param promise Promise of the coroutine, waiting on the request.
+     */
+    static void
+    cancel_wait(typename event_type::generic_promise_type &promise) {
+      auto &req = *static_cast<request_type *>(promise.waiter());
+      if (req.timeout_ev_ && req.timeout_ev_->pending()) {
+        req.timeout_ev_->abort();
+      }
+
+      if (req.res_ && req.state_ == state::waiting) {
+        req.res_->unlink(req);
+      }
+    }
+
+    /// Resource, or null if the resource was destroyed.
+    basic_resource *res_;
+
+    /// Priority of the request. Lower values are served first.
+    int priority_;
+
+    /// Whether the request may preempt users of the resource.
+    bool preempt_;
+
+    /// State of the request.
+    state state_ = state::idle;
+
+    /// Previous request in the list of waiting requests or users.
+    request_type *prev_ = nullptr;
+
+    /// Next request in the list of waiting requests or users.
+    request_type *next_ = nullptr;
+
+    /// Promise of the waiting coroutine.
+    typename event_type::generic_promise_type *promise_ = nullptr;
+
+    /// Timeout event while waiting with a timeout.
+    std::optional<event_type> timeout_ev_;
+
+    /// Event triggered when the request is preempted, if requested.
+    std::optional<event_type> preempted_ev_;
+
+    friend basic_resource;
+    friend timed_awaiter;
+  };
+
+  /**
+   * Constructor.
+   *
+   * @param sim Reference to the simulation.
+   * @param capacity Number of units.
+   */
+  basic_resource(Simulation &sim, std::uint64_t capacity)
+      : basic_resource{sim, capacity, false} {}
+
+  /**
+   * Destructor. Remaining requests are detached from the resource. Waiting
+   * requests are not granted anymore, and their timeouts are aborted, so
+   * their coroutines stay suspended.
+   */
+  ~basic_resource() {
+    detach(waiting_);
+    detach(users_);
+  }
+
+  basic_resource(const basic_resource &) = delete;
+  basic_resource &operator=(const basic_resource &) = delete;
+
+  /// @return Request for one unit, granted in FIFO order.
+  request_type request() { return request_type{*this, 0, false}; }
+
+  /// Release one unit, which is handed to the next waiting request.
+  void release() {
+    if (waiting_.head_) {
+      grant(*waiting_.head_);
+      return;
+    }
+
+    assert(available_ < capacity_);
+    ++available_;
+    record();
+  }
+
+  /// @return Number of units.
+  std::uint64_t capacity() const { return capacity_; }
+
+  /// @return Number of available units.
+  std::uint64_t available() const { return available_; }
+
+  /// @return Number of waiting requests.
+  std::size_t n_waiting() const { return waiting_.size_; }
+
+  /**
+   * Attach a monitor, which is reset and from then on records the number of
+   * units in use and of waiting requests over time. The monitor must stay
+   * alive while it is attached.
+   *
+   * @param levels Monitor to attach, or null to detach the current monitor.
+   */
+  void monitor(resource_monitor<time_type> *levels) {
+    monitor_ = levels;
+    if (levels) {
+      levels->in_use = time_weighted<time_type>{
+          sim_.now(), static_cast<double>(capacity_ - available_)};
+      levels->queue_length = time_weighted<time_type>{
+          sim_.now(), static_cast<double>(waiting_.size_)};
+    }
+  }
+
+protected:
+  /**
+   * Constructor.
+   *
+   * @param sim Reference to the simulation.
+   * @param capacity Number of units.
+   * @param preemptive Whether users are tracked so they can be preempted.
+   */
+  basic_resource(Simulation &sim, std::uint64_t capacity, bool preemptive)
+      : sim_{sim}, capacity_{capacity}, available_{capacity},
+        preemptive_{preemptive} {}
+
+  /**
+   * @param priority Priority of the request. Lower values are served first.
+   * @param preempt Whether the request may preempt users of the resource.
+   * @return Request for one unit.
+   */
+  request_type make_request(int priority, bool preempt) {
+    return request_type{*this, priority, preempt};
+  }
+
+  /**
+   * Release the unit held by a request. Does nothing if the request does not
+   * hold a unit anymore.
+   *
+   * @param req Request.
+   */
+  void release(request_type &req) {
+    if (req.res_ && (req.state_ == request_type::state::granted ||
+                     req.state_ == request_type::state::used)) {
+      give_back(req);
+    }
+  }
+
+  /**
+   * @param req Request.
+   * @return Whether the request was preempted.
+   */
+  static bool is_preempted(const request_type &req) {
+    return req.state_ == request_type::state::preempted;
+  }
+
+  /**
+   * @param req Request.
+   * @return Event triggered when the request is preempted.
+   */
+  event_type preempted_event(request_type &req) {
+    if (!req.preempted_ev_) {
+      req.preempted_ev_ = sim_.event();
+      if (is_preempted(req)) {
+        req.preempted_ev_->trigger();
+      }
+    }
+
+    return *req.preempted_ev_;
+  }
+
+private:
+  /// Intrusive list of requests sorted by priority, then insertion order.
+  struct request_list {
+    /// First request.
+    request_type *head_ = nullptr;
+
+    /// Last request.
+    request_type *tail_ = nullptr;
+
+    /// Number of requests.
+    std::size_t size_ = 0;
+
+    /**
+     * Insert a request behind all requests with the same or a lower priority
+     * value. The search starts at the tail, so requests of equal priority are
+     * inserted in O(1).
+     *
+     * @param req Request.
+     */
+    void insert(request_type &req) {
+      auto next = static_cast<request_type *>(nullptr);
+      auto prev = tail_;
+      while (prev && prev->priority_ > req.priority_) {
+        next = prev;
+        prev = prev->prev_;
+      }
+
+      req.prev_ = prev;
+      req.next_ = next;
+      (prev ? prev->next_ : head_) = &req;
+      (next ? next->prev_ : tail_) = &req;
+      ++size_;
+    }
+
+    /// @param req Request in the list to remove.
+    void erase(request_type &req) {
+      (req.prev_ ? req.prev_->next_ : head_) = req.next_;
+      (req.next_ ? req.next_->prev_ : tail_) = req.prev_;
+      req.prev_ = nullptr;
+      req.next_ = nullptr;
+      --size_;
+    }
+  };
+
+  /**
+   * Acquire a unit for a request which is awaited for the first time, or let
+   * it wait.
+   *
+   * @param req Request.
+   */
+  void acquire(request_type &req) {
+    if (available_ > 0) {
+      --available_;
+      use(req);
+      record();
+      return;
+    }
+
+    if (req.preempt_ && users_.tail_ &&
+        users_.tail_->priority_ > req.priority_) {
+      preempt(*users_.tail_);
+      use(req);
+      return;
+    }
+
+    req.state_ = request_type::state::waiting;
+    waiting_.insert(req);
+    record();
+  }
+
+  /**
+   * Mark a request as granted without waiting.
+   *
+   * @param req Request.
+   */
+  void use(request_type &req) {
+    req.state_ = request_type::state::granted;
+    if (preemptive_) {
+      users_.insert(req);
+    }
+  }
+
+  /**
+   * Hand a unit to a waiting request and resume its coroutine.
+   *
+   * @param req Waiting request.
+   */
+  void grant(request_type &req) {
+    unlink(req);
+    use(req);
+
+    if (req.timeout_ev_ && req.timeout_ev_->pending()) {
+      req.timeout_ev_->abort();
+    }
+
+    req.promise_->end_wait();
+    sim_.resume(*req.promise_);
+  }
+
+  /**
+   * Take the unit away from a user.
+   *
+   * @param req Request using a unit.
+   */
+  void preempt(request_type &req) {
+    users_.erase(req);
+    req.state_ = request_type::state::preempted;
+
+    if (req.preempted_ev_) {
+      req.preempted_ev_->trigger();
+    }
+  }
+
+  /**
+   * Return the unit of a granted request.
+   *
+   * @param req Granted request.
+   */
+  void give_back(request_type &req) {
+    if (preemptive_) {
+      users_.erase(req);
+    }
+
+    req.state_ = request_type::state::released;
+    release();
+  }
+
+  /// @param req Waiting request to remove.
+  void unlink(request_type &req) {
+    waiting_.erase(req);
+    req.state_ = request_type::state::idle;
+    record();
+  }
+
+  /// Pass the current levels to the monitor, if one is attached.
+  void record() {
+    if (monitor_) {
+      monitor_->set(sim_.now(), static_cast<double>(capacity_ - available_),
+                    static_cast<double>(waiting_.size_));
+    }
+  }
+
+  /// @param list List of requests to detach from the resource.
+  static void detach(request_list &list) {
+    for (auto req = list.head_; req;) {
+      auto next = req->next_;
+      if (req->timeout_ev_ && req->timeout_ev_->pending()) {
+        req->timeout_ev_->abort();
+      }
+
+      req->res_ = nullptr;
+      req->prev_ = nullptr;
+      req->next_ = nullptr;
+      req = next;
+    }
+
+    list = {};
+  }
+
+  /// Reference to the simulation.
+  Simulation &sim_;
+
+  /// Number of units.
+  std::uint64_t capacity_;
+
+  /// Number of available units.
+  std::uint64_t available_;
+
+  /// Whether users are tracked so they can be preempted.
+  bool preemptive_;
+
+  /// Waiting requests.
+  request_list waiting_;
+
+  /// Requests using a unit. Only tracked by preemptive resources.
+  request_list users_;
+
+  /// Attached monitor, or null.
+  resource_monitor<time_type> *monitor_ = nullptr;
+};
+
+/// @tparam Time Type used for simulation time.
+template <typename Time = double>
+using resource = basic_resource<simulation<Time>>;
+
+#ifdef FSCHUETZ04_SIMCPP20_EXTERN_TEMPLATES
+// Explicitly instantiated in src/simcpp20.cpp.
+extern template class basic_resource<simulation<double>>;
+
+extern template class basic_resource<simulation<std::uint64_t>>;
+#endif
+} // namespace simcpp20
@@ -3,18 +3,27 @@
 
 #pragma once
 
+#include <atomic>           // std::atomic, std::memory_order
 #include <cassert>          // assert
+#include <chrono>           // std::chrono
+#include <concepts>         // std::convertible_to
 #include <cstddef>          // std::size_t
 #include <cstdint>          // std::uint64_t
-#include <functional>       // std::greater
+#include <deque>            // std::deque, std::erase_if
 #include <initializer_list> // std::initializer_list
-#include <memory>           // std::make_shared, std::make_unique
-#include <queue>            // std::priority_queue
-#include <set>              // std::set
-#include <utility>          // std::forward
+#include <ranges>           // std::ranges::input_range, std::ranges::size
+#include <utility>          // std::exchange, std::forward, std::move
 #include <vector>           // std::vector
 
 #include "event.hpp"
+#include "heap.hpp"
+#include "injection_source.hpp"
+#include "interrupted.hpp"
+#include "memory.hpp"
+#include "observer.hpp"
+#include "pool.hpp"
+#include "radix_heap.hpp"
+#include "timer.hpp"
 #include "value_event.hpp"
 
 namespace simcpp20 {
@@ -27,19 +36,46 @@ using id_type = std::uint64_t;
  *
  *     simcpp20::simulation<> sim;
  *
+ * Events and processes allocate their shared state from a pool owned by the
+ * simulation, so they must not outlive it.
+ *
+ * Scheduled events are processed in order of their time, and events scheduled
+ * at the same time in the order they were scheduled. This order does not
+ * depend on the queue.
+ *
  * @tparam Time Type used for simulation time.
+ * @tparam Queue Queue of scheduled events, for example default_queue (a
+ * radix_heap for integral time and a binary_heap otherwise), quaternary_heap
+ * or calendar_queue.
+ * @tparam Observer Observer whose hooks are called while the simulation runs,
+ * for example no_observer (default) or counting_observer. See no_observer for
+ * the hooks.
  */
-template <typename Time = double> class simulation {
-private:
-  using event_type = simcpp20::event<Time>;
-
+template <typename Time, template <typename> class Queue, typename Observer>
+class simulation {
 public:
+  /// Type used for simulation time.
+  using time_type = Time;
+
+  /// Type of the events of this simulation.
+  using event_type = basic_event<simulation>;
+
+  /**
+   * Type of the value events of this simulation.
+   *
+   * @tparam Value Value type of the event.
+   */
+  template <typename Value>
+  using value_event_type = basic_value_event<Value, simulation>;
+
+  /// Type of the timers of this simulation.
+  using timer_type = basic_timer<simulation>;
+
   /// Destructor.
   ~simulation() {
-    std::set<std::coroutine_handle<>> temp_handles;
-    handles_.swap(temp_handles);
-    for (auto &handle : temp_handles) {
-      handle.destroy();
+    // Destroying a coroutine removes its promise from the list.
+    while (processes_) {
+      processes_->process_handle().destroy();
     }
   }
 
@@ -50,8 +86,8 @@ public:
    * @tparam Value Value type of the event.
    * @return New pending value event.
    */
-  template <typename Value> value_event<Value, Time> event() {
-    return value_event<Value, Time>{*this};
+  template <typename Value> value_event_type<Value> event() {
+    return value_event_type<Value>{*this};
   }
 
   /**
@@ -71,13 +107,20 @@ public:
    * @return New pending value event.
    */
   template <typename Value, typename... Args>
-  value_event<Value, Time> timeout(Time delay, Args &&...args) {
+  value_event_type<Value> timeout(Time delay, Args &&...args) {
     auto ev = event<Value>();
     ev.set_value(std::forward<Args>(args)...);
     schedule(ev, delay);
     return ev;
   }
 
+  /**
+   * @param period Time between two ticks. Must be positive.
+   * @return New timer ticking every period, with the first tick one period
+   * from now. See basic_timer.
+   */
+  timer_type periodic(Time period) { return timer_type{*this, period}; }
+
   /**
    * @param evs List of events.
    * @return New pending event which is triggered when any of the given events
@@ -94,7 +137,7 @@ public:
    * events is processed.
    */
   template <typename Value, typename... Args>
-  value_event<Value, Time> any_of(Args &&...evs) {
+  value_event_type<Value> any_of(Args &&...evs) {
     return any_of_internal(event<Value>(), std::forward<Args>(evs)...);
   }
 
@@ -104,33 +147,170 @@ public:
    * are processed.
    */
   template <typename... Args> event_type all_of(Args &&...evs) {
-    auto n_ptr = std::make_shared<std::size_t>(0);
-    return all_of_internal(event(), n_ptr, std::forward<Args>(evs)...);
+    auto all_of_ev = all_of_begin();
+    (all_of_add(all_of_ev, evs), ...);
+    return all_of_end(all_of_ev);
+  }
+
+  /**
+   * @tparam Range Type of the range of events.
+   * @param evs Range of events. The events are only accessed during the call.
+   * @return New pending value event which is triggered when any of the given
+   * events is processed. Its value is the index of that event in the range. If
+   * the range is empty, the event is never triggered.
+   */
+  template <std::ranges::input_range Range>
+    requires std::convertible_to<std::ranges::range_reference_t<Range>,
+                                 const event_type &>
+  value_event_type<std::size_t> any_of(Range &&evs) {
+    auto any_of_ev = event<std::size_t>();
+
+    std::size_t i = 0;
+    for (const event_type &ev : evs) {
+      if (ev.processed()) {
+        any_of_ev.trigger(i);
+        break;
+      }
+
+      ev.add_callback([any_of_ev, i](const auto &) { any_of_ev.trigger(i); });
+      ++i;
+    }
+
+    return any_of_ev;
+  }
+
+  /**
+   * The returned event and the number of events not yet processed share one
+   * allocation, and each event only gets a small callback, which is stored
+   * inline for the first callback of an event.
+   *
+   * @tparam Range Type of the range of events.
+   * @param evs Range of events. The events are only accessed during the call.
+   * @return New pending event which is triggered when all of the given events
+   * are processed. If the range is empty, the event is triggered immediately.
+   */
+  template <std::ranges::input_range Range>
+    requires std::convertible_to<std::ranges::range_reference_t<Range>,
+                                 const event_type &>
+  event_type all_of(Range &&evs) {
+    auto all_of_ev = all_of_begin();
+    for (const event_type &ev : evs) {
+      all_of_add(all_of_ev, ev);
+    }
+
+    return all_of_end(all_of_ev);
   }
 
   /**
+   * Schedule an event. An event is processed at most once, at the earliest
+   * time it is scheduled at: If the event is already scheduled at or before
+   * the new time, it keeps its place in the queue. If it is scheduled later,
+   * it is moved to the new time. Use reschedule to move an event to a later
+   * time.
+   *
    * @param ev Event to be processed.
    * @param delay Delay after which to process the event.
    */
   void schedule(const event_type &ev, Time delay = Time{0}) {
     assert(delay >= Time{0});
+    schedule_at(ev, now() + delay);
+  }
 
-    scheduled_evs_.emplace(now() + delay, next_id_, ev);
-    ++next_id_;
+  /**
+   * Schedule an event at an absolute time. See schedule for events which are
+   * already scheduled.
+   *
+   * @param ev Event to be processed.
+   * @param time Time at which to process the event. Must not be before the
+   * current simulation time.
+   */
+  void schedule_at(const event_type &ev, Time time) {
+    assert(time >= now());
+
+    if (!scheduled_by(ev, time)) {
+      enqueue(ev, time);
+    }
+  }
+
+  /**
+   * Move a pending scheduled event, for example a timeout, to a new time,
+   * which may be earlier or later. The old queue entry is discarded, so the
+   * event is processed only once, after the events scheduled before at the
+   * new time.
+   *
+   * @param ev Pending event.
+   * @param delay Delay after which to process the event.
+   */
+  void reschedule(const event_type &ev, Time delay) {
+    assert(ev.pending());
+    assert(delay >= Time{0});
+    enqueue(ev, now() + delay);
+  }
+
+  /**
+   * Schedule many events at once. The IDs are assigned in the order of the
+   * range, so events scheduled at the same time are processed in that order.
+   * The events scheduled with a delay are inserted into the queue together,
+   * which rebuilds a heap in O(n) instead of inserting each event in
+   * O(log n).
+   *
+   * @tparam Range Type of the range of (delay, event) pairs.
+   * @param evs Range of (delay, event) pairs. Events which are already
+   * scheduled are handled like by schedule.
+   */
+  template <std::ranges::input_range Range> void schedule_many(Range &&evs) {
+    std::vector<scheduled_event> batch;
+    if constexpr (std::ranges::sized_range<Range>) {
+      batch.reserve(std::ranges::size(evs));
+    }
+
+    std::size_t n_moved = 0;
+    for (auto &&[delay, ev] : evs) {
+      n_moved += schedule_many_add(batch, ev, delay);
+    }
+
+    schedule_many_end(batch, n_moved);
   }
 
-  /// Process the next scheduled event.
+  /**
+   * Create and schedule many timeouts at once, like schedule_many.
+   *
+   * @tparam Range Type of the range of delays.
+   * @param delays Range of delays after which to process the timeouts.
+   * @return New pending events in the order of the delays.
+   */
+  template <std::ranges::input_range Range>
+    requires std::convertible_to<std::ranges::range_reference_t<Range>, Time>
+  std::vector<event_type> timeouts(Range &&delays) {
+    std::vector<event_type> evs;
+    std::vector<scheduled_event> batch;
+    if constexpr (std::ranges::sized_range<Range>) {
+      evs.reserve(std::ranges::size(delays));
+      batch.reserve(std::ranges::size(delays));
+    }
+
+    for (Time delay : delays) {
+      evs.push_back(event());
+      schedule_many_add(batch, evs.back(), delay);
+    }
+
+    schedule_many_end(batch, 0);
+    return evs;
+  }
+
+  /**
+   * Process the next scheduled event. Messages posted to the injectors of the
+   * simulation since the last step are scheduled first.
+   */
   void step() {
-    auto sev = scheduled_evs_.top();
-    scheduled_evs_.pop();
-    now_ = sev.time_;
-    sev.ev_.process();
+    poll_injections();
+    process_next();
   }
 
   /// Run the simulation until no more events are scheduled.
   void run() {
-    while (!empty()) {
-      step();
+    while (!idle()) {
+      process_next();
     }
   }
 
@@ -144,20 +324,472 @@ public:
   void run_until(Time target) {
     assert(target >= now());
 
-    while (!empty() && scheduled_evs_.top().time_ < target) {
-      step();
+    while (!idle() && next_time() < target) {
+      process_next();
     }
 
     now_ = target;
   }
 
+  /**
+   * Run the simulation until the given number of events is processed or no
+   * more events are scheduled.
+   *
+   * @param max_steps Maximum number of events to process.
+   * @return Number of events processed.
+   */
+  std::size_t run_for(std::size_t max_steps) {
+    std::size_t n_steps = 0;
+    for (; n_steps < max_steps && !idle(); ++n_steps) {
+      process_next();
+    }
+
+    return n_steps;
+  }
+
+  /**
+   * Run the simulation until the wall-clock budget is used up or no more
+   * events are scheduled, for example to return control to the event loop of
+   * a front-end regularly. The clock is only read after each batch of
+   * check_interval events, so the budget may be exceeded by the time needed
+   * to process one batch.
+   *
+   * @tparam Rep Arithmetic type of the budget.
+   * @tparam Period Period of the budget.
+   * @param budget Wall-clock time to run for.
+   * @param check_interval Number of events to process between two reads of
+   * the clock. Must be positive.
+   * @return Number of events processed.
+   */
+  template <typename Rep, typename Period>
+  std::size_t run_for(std::chrono::duration<Rep, Period> budget,
+                      std::size_t check_interval = 256) {
+    assert(check_interval > 0);
+
+    using clock = std::chrono::steady_clock;
+    auto deadline = clock::now() + budget;
+    std::size_t n_steps = 0;
+    while (!idle()) {
+      n_steps += run_for(check_interval);
+      if (clock::now() >= deadline) {
+        break;
+      }
+    }
+
+    return n_steps;
+  }
+
   /// @return Whether no events are scheduled.
-  bool empty() const { return scheduled_evs_.empty(); }
+  bool empty() const {
+    return immediate_evs_.empty() && scheduled_evs_.empty();
+  }
+
+  /**
+   * @return Number of scheduled events and processes to start. Discarded
+   * queue entries are not counted.
+   */
+  std::size_t size() const {
+    return immediate_evs_.size() + scheduled_evs_.size() - n_discarded_;
+  }
+
+  /**
+   * @return Memory footprint of the simulation. Cheap to call, since the
+   * counts are maintained by the allocation points of the library.
+   */
+  memory_report memory() const {
+    return memory_report{
+        .events_ = pool_.usage(memory_kind::events),
+        .frames_ = pool_.usage(memory_kind::frames),
+        .immediate_ = pool_.usage(memory_kind::immediate),
+        .waiters_ = pool_.usage(memory_kind::waiters),
+        .callbacks_ = pool_.usage(memory_kind::callbacks),
+        .other_ = pool_.usage(memory_kind::other),
+        .pool_bytes_ = pool_.reserved_bytes(),
+        .n_scheduled_ = scheduled_evs_.size(),
+        .peak_scheduled_ = peak_scheduled_,
+        .scheduled_entry_size_ = sizeof(scheduled_event),
+        .n_immediate_ = immediate_evs_.size(),
+        .n_discarded_ = n_discarded_,
+    };
+  }
+
+  /// @return Reference to the observer of the simulation.
+  Observer &observer() { return observer_; }
 
   /// @return Current simulation time.
   Time now() const { return now_; }
 
+  /// @return Time of the next event to process. Some event must be scheduled.
+  Time next_time() const {
+    return next_is_immediate() ? now() : scheduled_evs_.top().time_;
+  }
+
 private:
+  class scheduled_event;
+
+  /// Process the next scheduled event without polling the injectors.
+  void process_next() {
+    if (next_is_immediate()) {
+      auto iev = std::move(immediate_evs_.front());
+      immediate_evs_.pop_front();
+      if (!iev.promise_) {
+        iev.ev_.data_->queue_id_ = event_type::data::unqueued;
+      }
+      prune();
+      observer_.on_step(now(), iev.id_, size());
+
+      if (iev.ev_.aborted()) {
+        observer_.on_abort(iev.id_);
+        if (iev.promise_) {
+          iev.promise_->process_handle().destroy();
+        }
+      } else if (iev.promise_) {
+        if (iev.start_) {
+          observer_.on_process_start(iev.promise_->id_);
+        } else {
+          observer_.on_resume(iev.promise_->id_);
+          if (iev.interrupt_) {
+            assert(iev.promise_->interrupt_pending());
+            interrupted_ = iev.promise_;
+          }
+        }
+        iev.promise_->process_handle().resume();
+        interrupted_ = nullptr;
+      } else {
+        iev.ev_.process();
+      }
+
+      return;
+    }
+
+    auto sev = scheduled_evs_.pop();
+    now_ = sev.time_;
+    sev.ev_.data_->queue_id_ = event_type::data::unqueued;
+    prune();
+    observer_.on_step(now(), sev.id_, size());
+    sev.ev_.process();
+  }
+
+  /**
+   * Schedule the messages posted to the injectors of the simulation, if any
+   * were posted since the last call. Costs one relaxed atomic load if none
+   * were posted.
+   */
+  void poll_injections() {
+    if (injected_.load(std::memory_order_relaxed)) [[unlikely]] {
+      drain_injections();
+    }
+  }
+
+  /**
+   * Poll the injectors of the simulation.
+   *
+   * @return Whether no events are scheduled afterwards.
+   */
+  bool idle() {
+    poll_injections();
+    return empty();
+  }
+
+  /**
+   * Schedule the messages posted to all injectors of the simulation. The flag
+   * is cleared before the injectors are drained, so a message posted while
+   * draining is either drained now or sets the flag again.
+   */
+  void drain_injections() {
+    injected_.exchange(false, std::memory_order_acq_rel);
+    for (auto source = sources_; source; source = source->next_) {
+      source->drain();
+    }
+  }
+
+  /**
+   * Attach an injection source. Called by the constructor of the source.
+   *
+   * @param source Injection source.
+   */
+  void attach(injection_source &source) {
+    source.next_ = sources_;
+    if (sources_) {
+      sources_->prev_ = &source;
+    }
+
+    sources_ = &source;
+  }
+
+  /**
+   * Detach an injection source. Called by the destructor of the source.
+   *
+   * @param source Injection source.
+   */
+  void detach(injection_source &source) {
+    if (source.prev_) {
+      source.prev_->next_ = source.next_;
+    } else {
+      sources_ = source.next_;
+    }
+
+    if (source.next_) {
+      source.next_->prev_ = source.prev_;
+    }
+  }
+
+  /**
+   * Signal that a message was posted to an injector. Called by the thread
+   * posting the message, after it was added to the injector.
+   */
+  void notify_injection() {
+    injected_.store(true, std::memory_order_release);
+  }
+
+  /**
+   * Events scheduled without delay and processes to start are kept in a FIFO
+   * queue instead of the heap. They are all scheduled at the current
+   * simulation time and ordered by their IDs, so comparing the front of the
+   * FIFO queue with the top of the heap yields the same order as a single heap
+   * would.
+   *
+   * @return Whether the next event to process is at the front of the FIFO
+   * queue.
+   */
+  bool next_is_immediate() const {
+    assert(!empty());
+
+    if (immediate_evs_.empty()) {
+      return false;
+    }
+
+    if (scheduled_evs_.empty()) {
+      return true;
+    }
+
+    auto &top = scheduled_evs_.top();
+    return top.time_ > now() || top.id_ > immediate_evs_.front().id_;
+  }
+
+  /**
+   * @param ev Event.
+   * @param time Time at which the event is to be scheduled.
+   * @return Whether the event is already scheduled at or before the time, so
+   * that it keeps its queue entry.
+   */
+  bool scheduled_by(const event_type &ev, Time time) const {
+    auto &data = *ev.data_;
+    return data.queue_id_ != event_type::data::unqueued &&
+           data.queue_time_ <= time;
+  }
+
+  /**
+   * Insert a queue entry for an event. If the event is already scheduled, its
+   * old entry is discarded.
+   *
+   * @param ev Event to be processed.
+   * @param time Time at which to process the event.
+   */
+  void enqueue(const event_type &ev, Time time) {
+    assert(time >= now());
+
+    bool moved = assign_id(ev, time);
+    if (time == now()) {
+      immediate_evs_.emplace_back(next_id_, ev);
+    } else {
+      scheduled_evs_.push(scheduled_event{time, next_id_, ev});
+      track_peak_scheduled();
+    }
+
+    ++next_id_;
+
+    if (moved) {
+      discard_entry();
+    }
+  }
+
+  /**
+   * Assign the next ID to an event which is scheduled. The caller inserts the
+   * queue entry and increments the next ID.
+   *
+   * @param ev Event to be processed.
+   * @param time Time at which to process the event.
+   * @return Whether the event was already scheduled, so its old entry has to
+   * be discarded after the new entry is inserted.
+   */
+  bool assign_id(const event_type &ev, Time time) {
+    observer_.on_schedule(now(), time, next_id_);
+
+    auto &data = *ev.data_;
+    bool moved = data.queue_id_ != event_type::data::unqueued;
+    data.queue_id_ = next_id_;
+    data.queue_time_ = time;
+    return moved;
+  }
+
+  /**
+   * Add one event to a batch of schedule_many. Events without delay are
+   * scheduled immediately, since the FIFO queue is already in ID order.
+   *
+   * @param batch Queue entries to insert at the end of the batch.
+   * @param ev Event to be processed.
+   * @param delay Delay after which to process the event.
+   * @return Whether the old entry of the event has to be discarded.
+   */
+  bool schedule_many_add(std::vector<scheduled_event> &batch,
+                         const event_type &ev, Time delay) {
+    assert(delay >= Time{0});
+
+    auto time = now() + delay;
+    if (scheduled_by(ev, time)) {
+      return false;
+    }
+
+    bool moved = assign_id(ev, time);
+    if (time == now()) {
+      immediate_evs_.emplace_back(next_id_, ev);
+    } else {
+      batch.emplace_back(time, next_id_, ev);
+    }
+
+    ++next_id_;
+    return moved;
+  }
+
+  /**
+   * Finish a batch of schedule_many. Old entries of moved events are only
+   * discarded after all new entries are inserted, since an event may occur
+   * in the batch more than once.
+   *
+   * @param batch Queue entries to insert. Moved into the queue.
+   * @param n_moved Number of events of the batch which were already
+   * scheduled.
+   */
+  void schedule_many_end(std::vector<scheduled_event> &batch,
+                         std::size_t n_moved) {
+    scheduled_evs_.push_many(std::move(batch));
+    track_peak_scheduled();
+
+    if (n_moved > 0) {
+      discard_entry(n_moved);
+    }
+  }
+
+  /// Remember the highest number of entries in the queue.
+  void track_peak_scheduled() {
+    if (scheduled_evs_.size() > peak_scheduled_) {
+      peak_scheduled_ = scheduled_evs_.size();
+    }
+  }
+
+  /**
+   * Remove the queue entry of an aborted event. Called by event::abort.
+   *
+   * @param ev Aborted event.
+   */
+  void unqueue(const event_type &ev) {
+    ev.data_->queue_id_ = event_type::data::unqueued;
+    discard_entry();
+  }
+
+  /**
+   * Remove the queue entry of an event, if it is scheduled, without aborting
+   * it. Called by timers which are destroyed.
+   *
+   * @param ev Event.
+   */
+  void cancel(const event_type &ev) {
+    if (ev.data_->queue_id_ != event_type::data::unqueued) {
+      unqueue(ev);
+    }
+  }
+
+  /**
+   * Account for queue entries which were discarded. Discarded entries at the
+   * front of the queues are removed immediately. If most entries are
+   * discarded, all of them are removed, so the queues stay proportional to
+   * the number of live entries.
+   *
+   * @param n Number of discarded entries.
+   */
+  void discard_entry(std::size_t n = 1) {
+    n_discarded_ += n;
+    prune();
+
+    auto n_entries = immediate_evs_.size() + scheduled_evs_.size();
+    if (n_discarded_ >= min_compaction && 2 * n_discarded_ > n_entries) {
+      std::erase_if(immediate_evs_,
+                    [](const immediate_event &iev) { return iev.discarded(); });
+      scheduled_evs_.erase_if(
+          [](const scheduled_event &sev) { return sev.discarded(); });
+      n_discarded_ = 0;
+    }
+  }
+
+  /// Remove discarded entries from the front of both queues.
+  void prune() {
+    while (n_discarded_ > 0 && !immediate_evs_.empty() &&
+           immediate_evs_.front().discarded()) {
+      immediate_evs_.pop_front();
+      --n_discarded_;
+    }
+
+    while (n_discarded_ > 0 && !scheduled_evs_.empty() &&
+           scheduled_evs_.top().discarded()) {
+      scheduled_evs_.pop();
+      --n_discarded_;
+    }
+  }
+
+  /**
+   * Schedule a process to be started at the current simulation time. Called
+   * by the initial awaitable of the process instead of scheduling an event.
+   *
+   * @param promise Promise of the process.
+   */
+  void start(typename event_type::generic_promise_type &promise) {
+    promise.process_event().data_->process_ = &promise;
+    promise.id_ = next_id_;
+    observer_.on_schedule(now(), now(), next_id_);
+    immediate_evs_.emplace_back(next_id_, promise.process_event(), &promise);
+    ++next_id_;
+  }
+
+  /**
+   * Schedule a suspended process to be resumed at the current simulation time.
+   * Used by awaitables which do not wait for an event.
+   *
+   * @param promise Promise of the process.
+   * @param interrupt Whether the process is resumed to throw its pending
+   * interrupt. Otherwise, a pending interrupt is thrown at its next wait.
+   */
+  void resume(typename event_type::generic_promise_type &promise,
+              bool interrupt = false) {
+    observer_.on_schedule(now(), now(), next_id_);
+    immediate_evs_.emplace_back(next_id_, promise.process_event(), &promise,
+                                false, interrupt);
+    ++next_id_;
+  }
+
+  /**
+   * Set a processed event back to pending and schedule it again. Used by
+   * timers to reuse their event.
+   *
+   * @param ev Processed event.
+   * @param time Time at which to process the event.
+   */
+  void rearm(const event_type &ev, Time time) {
+    assert(ev.processed());
+    ev.data_->state_ = event_type::state::pending;
+    schedule_at(ev, time);
+  }
+
+  /**
+   * Called by awaitables when the coroutine is resumed. Throws the pending
+   * interrupt if the coroutine was resumed to deliver it.
+   */
+  void check_interrupt() {
+    if (interrupted_) [[unlikely]] {
+      throw interrupted{std::exchange(interrupted_, nullptr)->take_interrupt()};
+    }
+  }
+
   /**
    * Consumes one event for `any_of` and forwards the remaining events.
    *
@@ -201,9 +833,9 @@ private:
    * @return Event that is triggered when any one of the events is processed.
    */
   template <typename Value>
-  value_event<Value, Time>
-  any_of_internal(value_event<Value, Time> any_of_ev,
-                  value_event<Value, Time> current_ev) {
+  value_event_type<Value>
+  any_of_internal(value_event_type<Value> any_of_ev,
+                  value_event_type<Value> current_ev) {
     if (current_ev.processed()) {
       any_of_ev.trigger(current_ev.value());
     } else {
@@ -216,43 +848,48 @@ private:
   }
 
   /**
-   * Consumes one event for `all_of` and forwards the remaining events.
+   * Start an `all_of` event. Its value is the number of events not yet
+   * processed, so that no separate counter needs to be allocated.
    *
-   * @tparam Args Type of the remaining events.
-   * @param all_of_ev Event to trigger when all of the events are processed.
-   * @param n_ptr Number of events not yet processed.
-   * @param current_ev Event to consume.
-   * @param next_evs Remaining events to forward.
-   * @return Event that is triggered when all of the events are processed.
+   * @return New pending event to trigger when all events are processed.
    */
-  template <typename... Args>
-  event_type all_of_internal(event_type all_of_ev,
-                             std::shared_ptr<size_t> n_ptr,
-                             event_type current_ev, Args &&...next_evs) {
-    all_of_internal(all_of_ev, n_ptr, current_ev);
-    return all_of_internal(all_of_ev, n_ptr, std::forward<Args>(next_evs)...);
+  value_event_type<std::size_t> all_of_begin() {
+    auto all_of_ev = event<std::size_t>();
+    all_of_ev.set_value(std::size_t{0});
+    return all_of_ev;
   }
 
   /**
-   * Consumes the final event for `all_of`.
+   * Add one event to an `all_of` event.
    *
-   * @param all_of_ev Event to trigger when all of the events are processed.
-   * @param n_ptr Number of events not yet processed.
-   * @param current_ev Event to consume.
-   * @return Event that is triggered when all of the events are processed.
-   */
-  event_type all_of_internal(event_type all_of_ev,
-                             std::shared_ptr<size_t> n_ptr,
-                             event_type current_ev) {
-    if (!current_ev.processed()) {
-      ++*n_ptr;
-
-      current_ev.add_callback([all_of_ev, n_ptr](const auto &) mutable {
-        --*n_ptr;
-        if (*n_ptr == 0) {
-          all_of_ev.trigger();
-        }
-      });
+   * @param all_of_ev Event to trigger when all events are processed.
+   * @param ev Event to add.
+   */
+  void all_of_add(const value_event_type<std::size_t> &all_of_ev,
+                  const event_type &ev) {
+    if (ev.processed()) {
+      return;
+    }
+
+    ++*all_of_ev.value_data().value_;
+    ev.add_callback([all_of_ev](const auto &) {
+      auto &n = *all_of_ev.value_data().value_;
+      --n;
+      if (n == 0) {
+        all_of_ev.event_type::trigger();
+      }
+    });
+  }
+
+  /**
+   * Finish an `all_of` event after all events are added.
+   *
+   * @param all_of_ev Event to trigger when all events are processed.
+   * @return The given event, triggered if all events are already processed.
+   */
+  event_type all_of_end(const value_event_type<std::size_t> &all_of_ev) {
+    if (all_of_ev.value() == 0) {
+      all_of_ev.event_type::trigger();
     }
 
     return all_of_ev;
@@ -284,6 +921,12 @@ private:
       return id_ > other.id_;
     }
 
+    /**
+     * @return Whether the entry was discarded because the event was aborted or
+     * scheduled again.
+     */
+    bool discarded() const { return ev_.data_->queue_id_ != id_; }
+
     /// Time at which to process the event.
     Time time_;
 
@@ -297,20 +940,131 @@ private:
     event_type ev_;
   };
 
-  /// Scheduled events.
-  std::priority_queue<scheduled_event, std::vector<scheduled_event>,
-                      std::greater<scheduled_event>>
-      scheduled_evs_;
+  /// One event or process scheduled at the current simulation time.
+  class immediate_event {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param id Incremental ID to sort events scheduled at the same time by
+     * insertion order.
+     * @param ev Event to process, or event of the process to start or resume.
+     * @param promise Promise of the process to start or resume, if any.
+     * @param start Whether the process is started instead of resumed.
+     * @param interrupt Whether the process is resumed to throw its pending
+     * interrupt.
+     */
+    explicit immediate_event(
+        id_type id, const event_type &ev,
+        typename event_type::generic_promise_type *promise = nullptr,
+        bool start = true, bool interrupt = false)
+        : id_{id}, ev_{ev}, promise_{promise}, start_{start},
+          interrupt_{interrupt} {}
+
+    /**
+     * @return Whether the entry was discarded because the event was aborted or
+     * scheduled again. Entries starting or resuming a process are never
+     * discarded.
+     */
+    bool discarded() const { return !promise_ && ev_.data_->queue_id_ != id_; }
+
+    /**
+     * Incremental ID to sort events scheduled at the same time by insertion
+     * order.
+     */
+    id_type id_;
+
+    /// Event to process, or event of the process to start or resume.
+    event_type ev_;
+
+    /**
+     * Promise of the process to start or resume. If set, the process is
+     * started or resumed instead of processing the event.
+     */
+    typename event_type::generic_promise_type *promise_;
+
+    /// Whether the process is started instead of resumed.
+    bool start_;
+
+    /// Whether the process is resumed to throw its pending interrupt.
+    bool interrupt_;
+  };
+
+  /**
+   * Pool for the shared state of events. Declared first so that it is
+   * destroyed after all members holding events.
+   */
+  pool pool_;
+
+  /// Events scheduled with a delay.
+  Queue<scheduled_event> scheduled_evs_;
+
+  /**
+   * Events scheduled without delay and processes to start, in the order they
+   * were scheduled.
+   */
+  std::deque<immediate_event,
+             pool_allocator<immediate_event, memory_kind::immediate>>
+      immediate_evs_{
+          pool_allocator<immediate_event, memory_kind::immediate>{pool_}};
 
   /// Current simulation time.
   Time now_ = Time{0};
 
+  /// Observer of the simulation.
+  [[no_unique_address]] Observer observer_;
+
   /// Next ID for scheduling an event.
   id_type next_id_ = 0;
 
-  /// Set of coroutine handles belonging to pending processes.
-  std::set<std::coroutine_handle<>> handles_;
+  /// Number of discarded entries remaining in the queues.
+  std::size_t n_discarded_ = 0;
+
+  /// Highest number of entries in the queue of events scheduled with a delay.
+  std::size_t peak_scheduled_ = 0;
+
+  /// Smallest number of discarded entries for which the queues are compacted.
+  static constexpr std::size_t min_compaction = 64;
+
+  /**
+   * Promises of pending processes, linked through the promises themselves.
+   * Used to destroy the remaining coroutines with the simulation.
+   */
+  typename event_type::generic_promise_type *processes_ = nullptr;
 
+  /**
+   * Promise of the process which is being resumed to deliver its pending
+   * interrupt, or null.
+   */
+  typename event_type::generic_promise_type *interrupted_ = nullptr;
+
+  /// Injection sources attached to the simulation, linked through themselves.
+  injection_source *sources_ = nullptr;
+
+  /**
+   * Whether a message was posted to an injector since the injectors were last
+   * drained. The only member written by other threads.
+   */
+  std::atomic<bool> injected_ = false;
+
+  friend event_type;
   friend class event_type::generic_promise_type;
+  template <typename, typename> friend class basic_value_event;
+  template <typename, typename> friend class basic_injector;
+  template <typename> friend class basic_resource;
+  template <typename, typename, typename> friend class basic_store;
+  template <typename> friend class basic_timer;
 };
+
+#ifdef FSCHUETZ04_SIMCPP20_EXTERN_TEMPLATES
+// Explicitly instantiated in src/simcpp20.cpp, which is compiled into the
+// fschuetz04::simcpp20_compiled target.
+extern template class simulation<double>;
+extern template class basic_event<simulation<double>>;
+extern template class basic_timer<simulation<double>>;
+
+extern template class simulation<std::uint64_t>;
+extern template class basic_event<simulation<std::uint64_t>>;
+extern template class basic_timer<simulation<std::uint64_t>>;
+#endif
 } // namespace simcpp20
@@ -0,0 +1,212 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm> // std::move
+#include <cassert>   // assert
+#include <cstddef>   // std::byte, std::size_t
+#include <cstdint>   // std::uint32_t
+#include <limits>    // std::numeric_limits
+#include <memory>    // std::allocator, std::allocator_traits, std::destroy,
+                     // std::destroy_at, std::uninitialized_move
+#include <new>       // ::new
+#include <utility>   // std::exchange, std::forward, std::move
+
+namespace simcpp20 {
+/**
+ * Sequence container storing up to a fixed number of elements inline. Only
+ * when more elements are added, the elements are moved to storage obtained
+ * from the allocator.
+ *
+ * @tparam T Type of the elements.
+ * @tparam N Number of elements stored inline.
+ * @tparam Allocator Allocator of the storage used when the elements do not
+ * fit inline. Moving a vector requires both vectors to use equal allocators.
+ */
+template <typename T, std::size_t N, typename Allocator = std::allocator<T>>
+class small_vector {
+public:
+  static_assert(N > 0);
+
+  /// Type of the allocator.
+  using allocator_type = Allocator;
+
+  /// Constructor.
+  small_vector() = default;
+
+  /**
+   * Constructor.
+   *
+   * @param alloc Allocator of the storage used when the elements do not fit
+   * inline.
+   */
+  explicit small_vector(const Allocator &alloc) : alloc_{alloc} {}
+
+  /// Destructor.
+  ~small_vector() { release(); }
+
+  /**
+   * Move constructor. The other vector is empty afterwards.
+   *
+   * @param other Vector to move.
+   */
+  small_vector(small_vector &&other) noexcept : alloc_{other.alloc_} {
+    steal(other);
+  }
+
+  /**
+   * Move assignment operator. The other vector is empty afterwards.
+   *
+   * @param other Vector to replace this vector with.
+   * @return Reference to this instance.
+   */
+  small_vector &operator=(small_vector &&other) noexcept {
+    if (this != &other) {
+      release();
+      steal(other);
+    }
+
+    return *this;
+  }
+
+  small_vector(const small_vector &) = delete;
+  small_vector &operator=(const small_vector &) = delete;
+
+  /**
+   * @tparam Args Types of arguments to construct the element with.
+   * @param args Arguments to construct the element with.
+   * @return Reference to the new element.
+   */
+  template <typename... Args> T &emplace_back(Args &&...args) {
+    if (size_ == capacity_) {
+      grow();
+    }
+
+    auto elem = ::new (data_ + size_) T(std::forward<Args>(args)...);
+    ++size_;
+    return *elem;
+  }
+
+  /// @param elem Element to add.
+  void push_back(T elem) { emplace_back(std::move(elem)); }
+
+  /**
+   * Remove one element. The remaining elements keep their order.
+   *
+   * @param pos Iterator to the element to remove.
+   */
+  void erase(T *pos) {
+    assert(pos >= begin() && pos < end());
+    std::move(pos + 1, end(), pos);
+    --size_;
+    std::destroy_at(end());
+  }
+
+  /// Remove all elements. Heap storage is kept for reuse.
+  void clear() {
+    std::destroy(begin(), end());
+    size_ = 0;
+  }
+
+  /// @return Whether the vector is empty.
+  bool empty() const { return size_ == 0; }
+
+  /// @return Number of elements.
+  std::size_t size() const { return size_; }
+
+  /// @return Iterator to the first element.
+  T *begin() { return data_; }
+
+  /// @return Iterator past the last element.
+  T *end() { return data_ + size_; }
+
+  /**
+   * @param i Index.
+   * @return Reference to the element at the given index.
+   */
+  T &operator[](std::size_t i) {
+    assert(i < size_);
+    return data_[i];
+  }
+
+private:
+  /// @return Whether the elements are stored inline.
+  bool is_inline() { return data_ == inline_data(); }
+
+  /// @return Pointer to the inline storage.
+  T *inline_data() { return reinterpret_cast<T *>(inline_); }
+
+  /// Move the elements to allocated storage of twice the capacity.
+  void grow() {
+    assert(capacity_ <= std::numeric_limits<size_type>::max() / 2);
+    auto capacity = 2 * capacity_;
+    auto data = alloc_traits::allocate(alloc_, capacity);
+    std::uninitialized_move(begin(), end(), data);
+    std::destroy(begin(), end());
+
+    if (!is_inline()) {
+      alloc_traits::deallocate(alloc_, data_, capacity_);
+    }
+
+    data_ = data;
+    capacity_ = capacity;
+  }
+
+  /// Destroy all elements and free allocated storage.
+  void release() {
+    clear();
+
+    if (!is_inline()) {
+      alloc_traits::deallocate(alloc_, data_, capacity_);
+      data_ = inline_data();
+      capacity_ = N;
+    }
+  }
+
+  /**
+   * Take over the elements of another vector, which is empty afterwards. This
+   * vector must be empty and use inline storage.
+   *
+   * @param other Vector to take the elements from.
+   */
+  void steal(small_vector &other) {
+    assert(alloc_ == other.alloc_);
+
+    if (other.is_inline()) {
+      std::uninitialized_move(other.begin(), other.end(), data_);
+      size_ = other.size_;
+      other.clear();
+      return;
+    }
+
+    data_ = std::exchange(other.data_, other.inline_data());
+    size_ = std::exchange(other.size_, 0);
+    capacity_ = std::exchange(other.capacity_, N);
+  }
+
+  /// Allocator traits of the allocator.
+  using alloc_traits = std::allocator_traits<Allocator>;
+
+  /**
+   * Type of the number of elements. Narrower than std::size_t, so that the
+   * allocator fits into the space saved.
+   */
+  using size_type = std::uint32_t;
+
+  /// Inline storage.
+  alignas(T) std::byte inline_[N * sizeof(T)];
+
+  /// Allocator of the storage used when the elements do not fit inline.
+  [[no_unique_address]] Allocator alloc_ = {};
+
+  /// Pointer to the elements, either inline or in allocated storage.
+  T *data_ = inline_data();
+
+  /// Number of elements.
+  size_type size_ = 0;
+
+  /// Number of elements fitting into the current storage.
+  size_type capacity_ = N;
+};
+} // namespace simcpp20
@@ -0,0 +1,820 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm>  // std::make_heap, std::pop_heap, std::push_heap
+#include <cassert>    // assert
+#include <coroutine>  // std::coroutine_handle
+#include <cstddef>    // std::size_t
+#include <deque>      // std::deque
+#include <functional> // std::invoke, std::less
+#include <limits>     // std::numeric_limits
+#include <optional>   // std::optional
+#include <utility>    // std::exchange, std::move
+#include <vector>     // std::vector
+
+#include "simulation.hpp"
+
+namespace simcpp20 {
+/**
+ * Items of a store, taken in the order they were put.
+ *
+ * @tparam Value Type of the items.
+ */
+template <typename Value> class fifo_items {
+public:
+  /// @param value Item to add.
+  void push(Value value) { items_.push_back(std::move(value)); }
+
+  /// @return First item, moved out of the container.
+  Value pop() {
+    assert(!empty());
+    auto value = std::move(items_.front());
+    items_.pop_front();
+    return value;
+  }
+
+  /**
+   * @tparam Filter Type of the filter.
+   * @param filter Callable with an item, returning whether it may be taken.
+   * @param out Set to the first matching item, which is removed.
+   * @return Whether a matching item was found.
+   */
+  template <typename Filter>
+  bool pop_if(Filter &&filter, std::optional<Value> &out) {
+    for (auto it = items_.begin(); it != items_.end(); ++it) {
+      if (std::invoke(filter, *it)) {
+        out.emplace(std::move(*it));
+        items_.erase(it);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /// @return Whether there are no items.
+  bool empty() const { return items_.empty(); }
+
+  /// @return Number of items.
+  std::size_t size() const { return items_.size(); }
+
+private:
+  /// Items in the order they were put.
+  std::deque<Value> items_;
+};
+
+/**
+ * Items of a store, taken in order of their priority. Items of equal
+ * priority are taken in an unspecified order.
+ *
+ * @tparam Value Type of the items.
+ * @tparam Compare Type of the comparison. Items which compare less are taken
+ * first.
+ */
+template <typename Value, typename Compare = std::less<Value>>
+class priority_items {
+public:
+  /// @param value Item to add.
+  void push(Value value) {
+    items_.push_back(std::move(value));
+    std::push_heap(items_.begin(), items_.end(), greater);
+  }
+
+  /// @return Item with the highest priority, moved out of the container.
+  Value pop() {
+    assert(!empty());
+    std::pop_heap(items_.begin(), items_.end(), greater);
+    auto value = std::move(items_.back());
+    items_.pop_back();
+    return value;
+  }
+
+  /**
+   * Takes O(n) time, since the heap has to be searched and rebuilt.
+   *
+   * @tparam Filter Type of the filter.
+   * @param filter Callable with an item, returning whether it may be taken.
+   * @param out Set to the matching item with the highest priority, which is
+   * removed.
+   * @return Whether a matching item was found.
+   */
+  template <typename Filter>
+  bool pop_if(Filter &&filter, std::optional<Value> &out) {
+    auto best = items_.end();
+    for (auto it = items_.begin(); it != items_.end(); ++it) {
+      if ((best == items_.end() || Compare{}(*it, *best)) &&
+          std::invoke(filter, *it)) {
+        best = it;
+      }
+    }
+
+    if (best == items_.end()) {
+      return false;
+    }
+
+    out.emplace(std::move(*best));
+    *best = std::move(items_.back());
+    items_.pop_back();
+    std::make_heap(items_.begin(), items_.end(), greater);
+    return true;
+  }
+
+  /// @return Whether there are no items.
+  bool empty() const { return items_.empty(); }
+
+  /// @return Number of items.
+  std::size_t size() const { return items_.size(); }
+
+private:
+  /// Comparison making the standard max-heap a min-heap.
+  static constexpr auto greater = [](const Value &a, const Value &b) {
+    return Compare{}(b, a);
+  };
+
+  /// Binary heap of the items.
+  std::vector<Value> items_;
+};
+
+/**
+ * Store holding items which processes put and get, for example as a queue
+ * between producers and consumers:
+ *
+ *     co_await store.put(std::move(part));
+ *     auto part = co_await store.get();
+ *
+ * Like the requests of basic_resource, put and get return awaitables which
+ * serve as nodes of intrusive lists of waiting processes. They live in the
+ * coroutine frame, so waiting does not allocate, and an item put while a
+ * process waits for one is moved directly into the frame of that process.
+ * Items are never copied.
+ *
+ * A put is attempted right away, so no co_await is needed as long as the
+ * store has room, for example if it is unbounded. A put which does not fit
+ * waits until it is awaited and room is made, and its item is dropped if it
+ * is destroyed before.
+ *
+ * get(filter) only takes items for which the filter returns true. An item
+ * which is put is handed to the first waiting process whose filter matches,
+ * so waiting without filters is O(1) even if thousands of processes wait.
+ *
+ * Both can wait with a timeout, which stops the put or get if it passes
+ * first, without a second process interrupting the waiting one:
+ *
+ *     auto get = store.get();
+ *     if (auto part = co_await get.wait_for(patience)) { ... }
+ *
+ * @tparam Value Type of the items.
+ * @tparam Simulation Type of the simulation.
+ * @tparam Items Container of the items, which decides the order in which
+ * they are taken: fifo_items or priority_items.
+ */
+template <typename Value, typename Simulation,
+          typename Items = fifo_items<Value>>
+class basic_store {
+public:
+  /// Type used for simulation time.
+  using time_type = typename Simulation::time_type;
+
+  /// Type of the events of the simulation.
+  using event_type = typename Simulation::event_type;
+
+private:
+  /// Node of an intrusive list of waiting puts or gets.
+  struct node {
+    /// Store, or null if the store was destroyed.
+    basic_store *store_;
+
+    /// Previous node in the list.
+    node *prev_ = nullptr;
+
+    /// Next node in the list.
+    node *next_ = nullptr;
+
+    /// Whether the node is in a list of the store.
+    bool waiting_ = false;
+
+    /// Promise of the waiting coroutine, if it was suspended.
+    typename event_type::generic_promise_type *promise_ = nullptr;
+
+    /// Timeout event while waiting with a timeout.
+    std::optional<event_type> timeout_ev_ = {};
+
+    /// Abort the timeout, if it is pending.
+    void abort_timeout() {
+      if (timeout_ev_ && timeout_ev_->pending()) {
+        timeout_ev_->abort();
+      }
+    }
+
+    /**
+     * Throw simcpp20::interrupted if the coroutine was resumed because it was
+     * interrupted.
+     */
+    void check_interrupt() {
+      if (promise_) {
+        promise_->sim_.check_interrupt();
+      }
+    }
+  };
+
+  /// Intrusive FIFO list of waiting puts or gets.
+  struct node_list {
+    /// First node.
+    node *head_ = nullptr;
+
+    /// Last node.
+    node *tail_ = nullptr;
+
+    /// Number of nodes.
+    std::size_t size_ = 0;
+
+    /// @param n Node to append.
+    void push_back(node &n) {
+      n.prev_ = tail_;
+      n.next_ = nullptr;
+      (tail_ ? tail_->next_ : head_) = &n;
+      tail_ = &n;
+      n.waiting_ = true;
+      ++size_;
+    }
+
+    /// @param n Node in the list to remove.
+    void erase(node &n) {
+      (n.prev_ ? n.prev_->next_ : head_) = n.next_;
+      (n.next_ ? n.next_->prev_ : tail_) = n.prev_;
+      n.prev_ = nullptr;
+      n.next_ = nullptr;
+      n.waiting_ = false;
+      --size_;
+    }
+  };
+
+public:
+  /// Capacity of a store without bound.
+  static constexpr std::size_t unbounded =
+      std::numeric_limits<std::size_t>::max();
+
+  class put_type;
+  class get_type;
+
+  /// Awaitable waiting for a put with a timeout.
+  class timed_put_type {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param put Put to wait for.
+     * @param timeout Time after which to stop waiting.
+     */
+    timed_put_type(put_type &put, time_type timeout)
+        : put_{put}, timeout_{timeout} {}
+
+    /// @return Whether the put is done without waiting.
+    bool await_ready() { return put_.await_ready(); }
+
+    /**
+     * Wait for the put to be done or the timeout to pass.
+     *
+     * @tparam Promise Promise type of the coroutine.
+     * @param handle Coroutine handle.
+     */
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) {
+      auto &put = put_;
+      put.timeout_ev_ = put.store_->sim_.timeout(timeout_);
+      put.timeout_ev_->add_callback([&put](const auto &) { put.expire(); });
+      put.await_suspend(handle);
+    }
+
+    /**
+     * @return Whether the put is done. Otherwise, the put keeps its item and
+     * can be awaited again.
+     */
+    bool await_resume() {
+      put_.await_resume();
+      return put_.done();
+    }
+
+  private:
+    /// Put to wait for.
+    put_type &put_;
+
+    /// Time after which to stop waiting.
+    time_type timeout_;
+  };
+
+  /// Awaitable waiting for a get with a timeout.
+  class timed_get_type {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param get Get to wait for.
+     * @param timeout Time after which to stop waiting.
+     */
+    timed_get_type(get_type &get, time_type timeout)
+        : get_{get}, timeout_{timeout} {}
+
+    /// @return Whether an item was taken without waiting.
+    bool await_ready() { return get_.await_ready(); }
+
+    /**
+     * Wait for an item or the timeout to pass.
+     *
+     * @tparam Promise Promise type of the coroutine.
+     * @param handle Coroutine handle.
+     */
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) {
+      auto &get = get_;
+      get.timeout_ev_ = get.store_->sim_.timeout(timeout_);
+      get.timeout_ev_->add_callback([&get](const auto &) { get.expire(); });
+      get.await_suspend(handle);
+    }
+
+    /**
+     * Throws simcpp20::interrupted if the coroutine was resumed because it
+     * was interrupted.
+     *
+     * @return Item, moved out of the get, or no value if the timeout passed.
+     */
+    std::optional<Value> await_resume() {
+      get_.check_interrupt();
+      return std::exchange(get_.value_, std::nullopt);
+    }
+
+  private:
+    /// Get to wait for.
+    get_type &get_;
+
+    /// Time after which to stop waiting.
+    time_type timeout_;
+  };
+
+  /// Awaitable putting one item into the store.
+  class put_type : node {
+  public:
+    /// Destructor. Cancels the put if it still waits, dropping its item.
+    ~put_type() {
+      this->abort_timeout();
+      if (this->store_ && this->waiting_) {
+        this->store_->putters_.erase(*this);
+      }
+    }
+
+    put_type(const put_type &) = delete;
+    put_type &operator=(const put_type &) = delete;
+
+    /// @return Whether the item is in the store or was handed to a getter.
+    bool done() const { return !value_; }
+
+    /**
+     * Called when using co_await on the put. Tries the put again if it was
+     * cancelled by an interrupt.
+     *
+     * @return Whether the put is done.
+     */
+    bool await_ready() {
+      if (!done() && !this->waiting_) {
+        assert(this->store_);
+        this->store_->offer(*this);
+      }
+
+      return done();
+    }
+
+    /**
+     * Called when a coroutine is suspended after using co_await on the put.
+     *
+     * @tparam Promise Promise type of the coroutine.
+     * @param handle Coroutine handle.
+     */
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) {
+      this->promise_ = &handle.promise();
+      this->promise_->wait(this, &cancel_wait);
+    }
+
+    /**
+     * Called when the coroutine is resumed. Throws simcpp20::interrupted if
+     * the coroutine was resumed because it was interrupted.
+     */
+    void await_resume() { this->check_interrupt(); }
+
+    /**
+     * Wait until the put is done or the timeout passed. If the timeout passes
+     * first, the put stops waiting and keeps its item.
+     *
+     *     auto put = store.put(std::move(part));
+     *     if (!co_await put.wait_for(patience)) { ... }
+     *
+     * @param timeout Time after which to stop waiting.
+     * @return Awaitable returning whether the put is done.
+     */
+    timed_put_type wait_for(time_type timeout) {
+      return timed_put_type{*this, timeout};
+    }
+
+  private:
+    /**
+     * Constructor. Puts the item right away if the store has room.
+     *
+     * @param store Store to put the item into.
+     * @param value Item.
+     */
+    put_type(basic_store &store, Value value)
+        : node{&store}, value_{std::move(value)} {
+      store.offer(*this);
+    }
+
+    /**
+     * Stop waiting after the timeout passed. The timeout is aborted when the
+     * put stops waiting or the store is destroyed, so the store still exists.
+     */
+    void expire() {
+      assert(this->store_ && this->waiting_);
+      this->store_->putters_.erase(*this);
+      this->store_->resume(*this);
+    }
+
+    /**
+     * Stop waiting because the coroutine was interrupted. The item is kept,
+     * so the put can be awaited again.
+     *
+     * @param promise Promise of the coroutine, waiting on the put.
+     */
+    static void
+    cancel_wait(typename event_type::generic_promise_type &promise) {
+      auto &put = *static_cast<put_type *>(promise.waiter());
+      put.abort_timeout();
+      if (put.store_ && put.waiting_) {
+        put.store_->putters_.erase(put);
+      }
+    }
+
+    /// Item, until it is put.
+    std::optional<Value> value_;
+
+    friend basic_store;
+    friend timed_put_type;
+  };
+
+  /// Awaitable getting one item from the store. Resumes with the item.
+  class get_type : node {
+  public:
+    /// Destructor. Cancels the get if it still waits.
+    ~get_type() {
+      this->abort_timeout();
+      if (this->store_ && this->waiting_) {
+        this->store_->getters_.erase(*this);
+      }
+    }
+
+    get_type(const get_type &) = delete;
+    get_type &operator=(const get_type &) = delete;
+
+    /**
+     * Called when using co_await on the get. Tries to take an item without
+     * waiting.
+     *
+     * @return Whether an item was taken.
+     */
+    bool await_ready() {
+      if (!value_ && !this->waiting_) {
+        assert(this->store_);
+        this->store_->take(*this);
+      }
+
+      return value_.has_value();
+    }
+
+    /**
+     * Called when a coroutine is suspended after using co_await on the get.
+     *
+     * @tparam Promise Promise type of the coroutine.
+     * @param handle Coroutine handle.
+     */
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) {
+      this->promise_ = &handle.promise();
+      this->promise_->wait(this, &cancel_wait);
+    }
+
+    /**
+     * Called when the coroutine is resumed. Throws simcpp20::interrupted if
+     * the coroutine was resumed because it was interrupted.
+     *
+     * @return Item, moved out of the awaitable.
+     */
+    Value await_resume() {
+      this->check_interrupt();
+
+      assert(value_);
+      auto value = std::move(*value_);
+      value_.reset();
+      return value;
+    }
+
+    /**
+     * Wait until an item is taken or the timeout passed. If the timeout
+     * passes first, the get stops waiting.
+     *
+     *     auto get = store.get();
+     *     if (auto part = co_await get.wait_for(patience)) { ... }
+     *
+     * @param timeout Time after which to stop waiting.
+     * @return Awaitable returning the item, or no value if the timeout passed.
+     */
+    timed_get_type wait_for(time_type timeout) {
+      return timed_get_type{*this, timeout};
+    }
+
+  protected:
+    /// Function returning whether a get may take an item.
+    using filter_function = bool (*)(const get_type &, const Value &);
+
+    /**
+     * Constructor.
+     *
+     * @param store Store to get an item from.
+     * @param filter Filter of the get, or null to take any item.
+     */
+    explicit get_type(basic_store &store, filter_function filter = nullptr)
+        : node{&store}, filter_{filter} {}
+
+  private:
+    /**
+     * @param value Item.
+     * @return Whether the get may take the item.
+     */
+    bool matches(const Value &value) const {
+      return !filter_ || filter_(*this, value);
+    }
+
+    /**
+     * Stop waiting after the timeout passed. The timeout is aborted when the
+     * get stops waiting or the store is destroyed, so the store still exists.
+     */
+    void expire() {
+      assert(this->store_ && this->waiting_);
+      this->store_->getters_.erase(*this);
+      this->store_->resume(*this);
+    }
+
+    /**
+     * Stop waiting because the coroutine was interrupted.
+     *
+     * @param promise Promise of the coroutine, waiting on the get.
+     */
+    static void
+    cancel_wait(typename event_type::generic_promise_type &promise) {
+      auto &get = *static_cast<get_type *>(promise.waiter());
+      get.abort_timeout();
+      if (get.store_ && get.waiting_) {
+        get.store_->getters_.erase(get);
+      }
+    }
+
+    /// Filter of the get, or null.
+    filter_function filter_;
+
+    /// Item, once it is taken.
+    std::optional<Value> value_;
+
+    friend basic_store;
+    friend timed_get_type;
+  };
+
+  /**
+   * Awaitable getting one item matching a filter from the store. Resumes with
+   * the item.
+   *
+   * @tparam Filter Type of the filter.
+   */
+  template <typename Filter> class filtered_get_type : public get_type {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param store Store to get an item from.
+     * @param filter Callable with an item, returning whether it may be taken.
+     */
+    filtered_get_type(basic_store &store, Filter filter)
+        : get_type{store, &matches_filter}, filter_{std::move(filter)} {}
+
+  private:
+    /**
+     * @param get Get of this type.
+     * @param value Item.
+     * @return Whether the filter of the get matches the item.
+     */
+    static bool matches_filter(const get_type &get, const Value &value) {
+      return std::invoke(static_cast<const filtered_get_type &>(get).filter_,
+                         value);
+    }
+
+    /// Filter.
+    Filter filter_;
+  };
+
+  /**
+   * Constructor.
+   *
+   * @param sim Reference to the simulation.
+   * @param capacity Number of items the store holds at most.
+   */
+  explicit basic_store(Simulation &sim, std::size_t capacity = unbounded)
+      : sim_{sim}, capacity_{capacity} {
+    assert(capacity > 0);
+  }
+
+  /**
+   * Destructor. Waiting puts and gets are detached from the store, and their
+   * timeouts are aborted, so their coroutines stay suspended.
+   */
+  ~basic_store() {
+    detach(putters_);
+    detach(getters_);
+  }
+
+  basic_store(const basic_store &) = delete;
+  basic_store &operator=(const basic_store &) = delete;
+
+  /**
+   * @param value Item to put into the store.
+   * @return Awaitable waiting until the item is in the store.
+   */
+  put_type put(Value value) { return put_type{*this, std::move(value)}; }
+
+  /// @return Awaitable taking the next item, resuming with the item.
+  get_type get() { return get_type{*this}; }
+
+  /**
+   * @tparam Filter Type of the filter.
+   * @param filter Callable with an item, returning whether it may be taken.
+   * @return Awaitable taking the next item matching the filter, resuming
+   * with the item.
+   */
+  template <typename Filter> filtered_get_type<Filter> get(Filter filter) {
+    return filtered_get_type<Filter>{*this, std::move(filter)};
+  }
+
+  /// @return Number of items in the store.
+  std::size_t size() const { return items_.size(); }
+
+  /// @return Number of items the store holds at most.
+  std::size_t capacity() const { return capacity_; }
+
+  /// @return Number of waiting puts.
+  std::size_t n_putters() const { return putters_.size_; }
+
+  /// @return Number of waiting gets.
+  std::size_t n_getters() const { return getters_.size_; }
+
+private:
+  /**
+   * Hand the item of a put to the first matching waiting get, or add it to
+   * the items if there is room. Otherwise, the put waits.
+   *
+   * @param put Put whose item is not in the store yet.
+   */
+  void offer(put_type &put) {
+    if (!deliver(*put.value_)) {
+      putters_.push_back(put);
+      return;
+    }
+
+    put.value_.reset();
+  }
+
+  /**
+   * @param value Item to hand to the first matching waiting get or to add to
+   * the items. Moved from if the function returns true.
+   * @return Whether the item was handed over or added.
+   */
+  bool deliver(Value &value) {
+    for (auto n = getters_.head_; n; n = n->next_) {
+      auto &get = static_cast<get_type &>(*n);
+      if (get.matches(value)) {
+        getters_.erase(get);
+        get.value_.emplace(std::move(value));
+        resume(get);
+        return true;
+      }
+    }
+
+    if (items_.size() < capacity_) {
+      items_.push(std::move(value));
+      return true;
+    }
+
+    return false;
+  }
+
+  /**
+   * Take an item for a get which is awaited, or let it wait.
+   *
+   * @param get Get without an item.
+   */
+  void take(get_type &get) {
+    if (items_.empty()) {
+      getters_.push_back(get);
+      return;
+    }
+
+    if (!get.filter_) {
+      get.value_.emplace(items_.pop());
+    } else if (!items_.pop_if(
+                   [&get](const Value &value) { return get.matches(value); },
+                   get.value_)) {
+      getters_.push_back(get);
+      return;
+    }
+
+    admit_putters();
+  }
+
+  /// Add the items of waiting puts, in FIFO order, while there is room.
+  void admit_putters() {
+    while (putters_.head_) {
+      auto &put = static_cast<put_type &>(*putters_.head_);
+      if (!deliver(*put.value_)) {
+        return;
+      }
+
+      putters_.erase(put);
+      put.value_.reset();
+      resume(put);
+    }
+  }
+
+  /**
+   * Resume the coroutine of a put or get which stopped waiting, if it was
+   * suspended.
+   *
+   * @param n Put or get.
+   */
+  void resume(node &n) {
+    n.abort_timeout();
+    if (n.promise_) {
+      n.promise_->end_wait();
+      sim_.resume(*n.promise_);
+    }
+  }
+
+  /// @param list List of puts or gets to detach from the store.
+  static void detach(node_list &list) {
+    for (auto n = list.head_; n;) {
+      auto next = n->next_;
+      n->abort_timeout();
+      n->store_ = nullptr;
+      n->prev_ = nullptr;
+      n->next_ = nullptr;
+      n = next;
+    }
+
+    list = {};
+  }
+
+  /// Reference to the simulation.
+  Simulation &sim_;
+
+  /// Number of items the store holds at most.
+  std::size_t capacity_;
+
+  /// Items in the store.
+  Items items_;
+
+  /// Waiting puts.
+  node_list putters_;
+
+  /// Waiting gets.
+  node_list getters_;
+};
+
+/**
+ * Store whose items are taken in FIFO order, of a simulation using the
+ * default queue.
+ *
+ * @tparam Value Type of the items.
+ * @tparam Time Type used for simulation time.
+ */
+template <typename Value, typename Time = double>
+using store = basic_store<Value, simulation<Time>>;
+
+/**
+ * Store whose items are taken in order of their priority, of a simulation
+ * using the default queue.
+ *
+ * @tparam Value Type of the items.
+ * @tparam Time Type used for simulation time.
+ * @tparam Compare Type of the comparison. Items which compare less are taken
+ * first.
+ */
+template <typename Value, typename Time = double,
+          typename Compare = std::less<Value>>
+using priority_store =
+    basic_store<Value, simulation<Time>, priority_items<Value, Compare>>;
+} // namespace simcpp20
@@ -0,0 +1,159 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert>   // assert
+#include <coroutine> // std::coroutine_handle
+#include <utility>   // std::exchange, std::move
+
+#include "event.hpp"
+
+namespace simcpp20 {
+/**
+ * Timer ticking periodically. Created with simulation::periodic and used as
+ * awaitable, which waits for the next tick:
+ *
+ *     auto ticker = sim.periodic(period);
+ *     while (true) {
+ *       co_await ticker;
+ *       sample();
+ *     }
+ *
+ * The timer keeps one event, which is scheduled again in place after each
+ * tick, so ticking does not allocate. Ticks are at the creation time plus
+ * multiples of the period. The event is only scheduled again when the timer
+ * is awaited after a tick, so ticks during which no process waits for the
+ * timer are skipped.
+ *
+ * Timers can be moved, but not copied. Destroying a timer or assigning to it
+ * removes its pending tick from the queue. Processes still waiting for the
+ * timer are not resumed anymore and are destroyed with the simulation. The
+ * event is not aborted, since a timer may be destroyed with the frame of a
+ * process waiting for it.
+ *
+ * @tparam Simulation Type of the simulation.
+ */
+template <typename Simulation> class basic_timer {
+public:
+  /// Type used for simulation time.
+  using time_type = typename Simulation::time_type;
+
+  /**
+   * Constructor. The first tick is one period after the current time.
+   *
+   * @param sim Reference to the simulation.
+   * @param period Time between two ticks. Must be positive.
+   */
+  basic_timer(Simulation &sim, time_type period)
+      : sim_{&sim}, ev_{sim}, period_{period}, next_{sim.now() + period} {
+    assert(period > time_type{0});
+    sim.schedule_at(ev_, next_);
+  }
+
+  /// Destructor. Removes the pending tick from the queue.
+  ~basic_timer() { cancel(); }
+
+  basic_timer(const basic_timer &) = delete;
+  basic_timer &operator=(const basic_timer &) = delete;
+
+  /**
+   * Move constructor. The moved-from timer may only be destroyed or assigned
+   * to.
+   *
+   * @param other Timer to move.
+   */
+  basic_timer(basic_timer &&other) noexcept
+      : sim_{std::exchange(other.sim_, nullptr)}, ev_{std::move(other.ev_)},
+        period_{other.period_}, next_{other.next_} {}
+
+  /**
+   * Move assignment operator. Removes the pending tick of this timer from the
+   * queue. The moved-from timer may only be destroyed or assigned to.
+   *
+   * @param other Timer to replace this timer with.
+   * @return Reference to this instance.
+   */
+  basic_timer &operator=(basic_timer &&other) noexcept {
+    if (this != &other) {
+      cancel();
+      sim_ = std::exchange(other.sim_, nullptr);
+      ev_ = std::move(other.ev_);
+      period_ = other.period_;
+      next_ = other.next_;
+    }
+
+    return *this;
+  }
+
+  /// @return Time between two ticks.
+  time_type period() const { return period_; }
+
+  /**
+   * @return Time of the next tick, or of the last tick if the timer was not
+   * awaited since.
+   */
+  time_type next_time() const { return next_; }
+
+  /**
+   * Called when using co_await on the timer.
+   *
+   * @return Whether the coroutine can continue without waiting, which is
+   * never, since it always waits for the next tick.
+   */
+  bool await_ready() const { return false; }
+
+  /**
+   * Wait for the next tick. After a tick, the event is scheduled again at the
+   * first tick not before the current time.
+   *
+   * @tparam Promise Promise type of the coroutine.
+   * @param handle Coroutine handle.
+   */
+  template <typename Promise>
+  void await_suspend(std::coroutine_handle<Promise> handle) {
+    if (ev_.processed()) {
+      do {
+        next_ += period_;
+      } while (next_ < sim_->now());
+
+      sim_->rearm(ev_, next_);
+    }
+
+    ev_.await_suspend(handle);
+  }
+
+  /**
+   * Called when the coroutine is resumed. Throws simcpp20::interrupted if the
+   * coroutine was resumed because it was interrupted.
+   */
+  void await_resume() { ev_.await_resume(); }
+
+private:
+  /// Remove the pending tick from the queue, unless the timer was moved from.
+  void cancel() {
+    if (sim_) {
+      sim_->cancel(ev_);
+    }
+  }
+
+  /// Simulation of the timer, or null if the timer was moved from.
+  Simulation *sim_;
+
+  /// Event processed at each tick.
+  basic_event<Simulation> ev_;
+
+  /// Time between two ticks.
+  time_type period_;
+
+  /// Time of the tick the event is scheduled for.
+  time_type next_;
+};
+
+/**
+ * Timer of a simulation using the default queue.
+ *
+ * @tparam Time Type used for simulation time.
+ */
+template <typename Time = double> using timer = basic_timer<simulation<Time>>;
+} // namespace simcpp20
@@ -0,0 +1,345 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <array>              // std::array
+#include <condition_variable> // std::condition_variable
+#include <cstddef>            // std::size_t
+#include <cstdint>            // std::uint32_t, std::uint64_t
+#include <cstdio>             // std::FILE, std::fclose, std::fopen, std::fwrite
+#include <memory>             // std::make_unique, std::unique_ptr
+#include <mutex>              // std::mutex, std::unique_lock
+#include <stdexcept>          // std::runtime_error
+#include <string>             // std::string
+#include <thread>             // std::thread
+#include <type_traits>        // std::is_floating_point_v, std::is_signed_v
+#include <vector>             // std::vector
+
+namespace simcpp20 {
+/// Kind of a trace record.
+enum class trace_kind : std::uint32_t {
+  /**
+   * An event, a process start or a process resume was scheduled. The time is
+   * the time the entry is scheduled at.
+   */
+  schedule,
+  /// An event was processed. The count is the number of awaiting processes.
+  process,
+  /// A process was started. The ID is the ID of the process.
+  start,
+  /// A process was resumed. The ID is the ID of the process.
+  resume,
+  /// A process returned. The ID is the ID of the process.
+  end,
+  /// An aborted process was taken from the queue.
+  abort,
+};
+
+/**
+ * Fixed-size record of a trace.
+ *
+ * @tparam Time Type used for simulation time.
+ */
+template <typename Time> struct trace_record {
+  /// Simulation time.
+  Time time_;
+
+  /// ID of the queue entry, or of the process for process records.
+  std::uint64_t id_;
+
+  /// Kind of the record.
+  trace_kind kind_;
+
+  /// Number of processes awaiting a processed event, zero otherwise.
+  std::uint32_t count_;
+
+  /**
+   * @param other Other record.
+   * @return Whether all fields are equal.
+   */
+  bool operator==(const trace_record &other) const = default;
+};
+
+/// Header at the start of every trace file.
+struct trace_header {
+  /// Magic bytes identifying a trace file.
+  std::array<char, 8> magic_;
+
+  /// Version of the file format.
+  std::uint32_t version_;
+
+  /// Size of one record in bytes.
+  std::uint32_t record_size_;
+
+  /// Size of the time type in bytes.
+  std::uint32_t time_size_;
+
+  /// Properties of the time type, see is_floating and is_signed.
+  std::uint32_t time_flags_;
+
+  /// Flag set if the time type is a floating point type.
+  static constexpr std::uint32_t is_floating = 1;
+
+  /// Flag set if the time type is signed.
+  static constexpr std::uint32_t is_signed = 2;
+
+  /// Current version of the file format.
+  static constexpr std::uint32_t current_version = 1;
+
+  /// Magic bytes of trace files.
+  static constexpr std::array<char, 8> trace_magic = {'S', 'I', 'M', 'C',
+                                                      'P', 'P', 'T', 'R'};
+
+  /**
+   * @tparam Time Type used for simulation time.
+   * @return Header of a trace using the given time type.
+   */
+  template <typename Time> static trace_header make() {
+    return {trace_magic, current_version, sizeof(trace_record<Time>),
+            sizeof(Time),
+            (std::is_floating_point_v<Time> ? is_floating : 0) |
+                (std::is_signed_v<Time> ? is_signed : 0)};
+  }
+
+  /**
+   * @param other Other header.
+   * @return Whether all fields are equal.
+   */
+  bool operator==(const trace_header &other) const = default;
+};
+
+/**
+ * Append-only writer of trace records. Records are collected in one of two
+ * buffers. When the buffer is full, it is handed to a background thread which
+ * writes it to the file while the other buffer is filled, so the simulation
+ * only waits for the disk if it produces records faster than they are
+ * written.
+ *
+ * @tparam Record Type of the records.
+ */
+template <typename Record> class trace_writer {
+public:
+  /**
+   * Constructor. Creates or truncates the file and writes the header.
+   *
+   * @param path Path of the trace file.
+   * @param header Header of the trace file.
+   * @param buffer_size Number of records per buffer.
+   */
+  trace_writer(const std::string &path, const trace_header &header,
+               std::size_t buffer_size = std::size_t{1} << 16)
+      : file_{std::fopen(path.c_str(), "wb")}, buffer_size_{buffer_size} {
+    if (!file_) {
+      throw std::runtime_error{"cannot open trace file " + path};
+    }
+
+    if (std::fwrite(&header, sizeof(header), 1, file_) != 1) {
+      std::fclose(file_);
+      throw std::runtime_error{"cannot write trace file " + path};
+    }
+
+    for (auto &buffer : buffers_) {
+      buffer.reserve(buffer_size_);
+    }
+
+    thread_ = std::thread{[this] { write_buffers(); }};
+  }
+
+  /// Destructor. Writes the remaining records and closes the file.
+  ~trace_writer() {
+    if (!active_->empty()) {
+      hand_off();
+    }
+
+    {
+      std::unique_lock lock{mutex_};
+      stop_ = true;
+    }
+    cv_.notify_all();
+
+    thread_.join();
+    std::fclose(file_);
+  }
+
+  trace_writer(const trace_writer &) = delete;
+  trace_writer &operator=(const trace_writer &) = delete;
+
+  /// @param record Record to append.
+  void write(const Record &record) {
+    active_->push_back(record);
+    if (active_->size() == buffer_size_) {
+      hand_off();
+    }
+  }
+
+  /// @return Whether all records handed to the background thread were written.
+  bool good() const {
+    std::unique_lock lock{mutex_};
+    return !failed_;
+  }
+
+private:
+  /**
+   * Hand the active buffer to the background thread and continue with the
+   * other buffer, waiting until it was written if necessary.
+   */
+  void hand_off() {
+    std::unique_lock lock{mutex_};
+    cv_.wait(lock, [this] { return !full_; });
+
+    full_ = active_;
+    active_ = active_ == &buffers_[0] ? &buffers_[1] : &buffers_[0];
+
+    lock.unlock();
+    cv_.notify_all();
+  }
+
+  /// Write full buffers until the writer is destroyed. Run by the thread.
+  void write_buffers() {
+    std::unique_lock lock{mutex_};
+
+    while (true) {
+      cv_.wait(lock, [this] { return full_ || stop_; });
+      if (!full_) {
+        return;
+      }
+
+      auto buffer = full_;
+      lock.unlock();
+
+      auto n = std::fwrite(buffer->data(), sizeof(Record), buffer->size(),
+                           file_);
+      bool failed = n != buffer->size();
+      buffer->clear();
+
+      lock.lock();
+      failed_ = failed_ || failed;
+      full_ = nullptr;
+      cv_.notify_all();
+    }
+  }
+
+  /// Trace file.
+  std::FILE *file_;
+
+  /// Number of records per buffer.
+  std::size_t buffer_size_;
+
+  /// Buffers of records.
+  std::array<std::vector<Record>, 2> buffers_;
+
+  /// Buffer currently filled by the simulation.
+  std::vector<Record> *active_ = &buffers_[0];
+
+  /// Buffer handed to the background thread, or null.
+  std::vector<Record> *full_ = nullptr;
+
+  /// Whether the background thread should stop.
+  bool stop_ = false;
+
+  /// Whether writing a buffer failed.
+  bool failed_ = false;
+
+  /// Mutex protecting full_, stop_ and failed_.
+  mutable std::mutex mutex_;
+
+  /// Condition variable signalled when full_ or stop_ change.
+  std::condition_variable cv_;
+
+  /// Background thread writing full buffers.
+  std::thread thread_;
+};
+
+/**
+ * Observer writing a binary trace of a simulation. Nothing is recorded until
+ * a trace file is opened.
+ *
+ *     simcpp20::simulation<double, simcpp20::binary_heap,
+ *                          simcpp20::trace_observer<>> sim;
+ *     sim.observer().open("run.trace");
+ *
+ * @tparam Time Type used for simulation time.
+ */
+template <typename Time = double> class trace_observer {
+public:
+  /// Type of the records.
+  using record_type = trace_record<Time>;
+
+  /**
+   * Start writing a trace file. An open trace file is closed first.
+   *
+   * @param path Path of the trace file.
+   */
+  void open(const std::string &path) {
+    writer_.reset();
+    writer_ = std::make_unique<trace_writer<record_type>>(
+        path, trace_header::make<Time>());
+  }
+
+  /// Write the remaining records and close the trace file.
+  void close() { writer_.reset(); }
+
+  /// @return Whether a trace file is open.
+  bool is_open() const { return writer_ != nullptr; }
+
+  /// @see no_observer::on_schedule
+  void on_schedule(Time now, Time time, std::uint64_t id) {
+    now_ = now;
+    write(trace_kind::schedule, time, id);
+  }
+
+  /// @see no_observer::on_step
+  void on_step(Time now, std::uint64_t id, std::size_t) {
+    now_ = now;
+    step_id_ = id;
+  }
+
+  /// @see no_observer::on_process
+  void on_process(std::size_t n_promises, std::size_t) {
+    write(trace_kind::process, now_, step_id_,
+          static_cast<std::uint32_t>(n_promises));
+  }
+
+  /// @see no_observer::on_resume
+  void on_resume(std::uint64_t process) {
+    write(trace_kind::resume, now_, process);
+  }
+
+  /// @see no_observer::on_abort
+  void on_abort(std::uint64_t id) { write(trace_kind::abort, now_, id); }
+
+  /// @see no_observer::on_process_start
+  void on_process_start(std::uint64_t process) {
+    write(trace_kind::start, now_, process);
+  }
+
+  /// @see no_observer::on_process_end
+  void on_process_end(std::uint64_t process) {
+    write(trace_kind::end, now_, process);
+  }
+
+private:
+  /**
+   * @param kind Kind of the record.
+   * @param time Simulation time of the record.
+   * @param id ID of the queue entry or process.
+   * @param count Number of awaiting processes.
+   */
+  void write(trace_kind kind, Time time, std::uint64_t id,
+             std::uint32_t count = 0) {
+    if (writer_) {
+      writer_->write(record_type{time, id, kind, count});
+    }
+  }
+
+  /// Writer of the open trace file, or null.
+  std::unique_ptr<trace_writer<record_type>> writer_;
+
+  /// Simulation time of the last hook.
+  Time now_ = Time{0};
+
+  /// ID of the queue entry of the current step.
+  std::uint64_t step_id_ = 0;
+};
+} // namespace simcpp20
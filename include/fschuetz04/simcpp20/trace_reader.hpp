@@ -0,0 +1,170 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint64_t
+#include <cstdio>    // std::FILE, std::fclose, std::fopen, std::fread
+#include <optional>  // std::optional, std::nullopt
+#include <stdexcept> // std::runtime_error
+#include <string>    // std::string
+#include <vector>    // std::vector
+
+#include "trace.hpp"
+
+namespace simcpp20 {
+/**
+ * @param path Path of the trace file.
+ * @return Header of the trace file. Throws std::runtime_error if the file
+ * cannot be read or is no trace file.
+ */
+inline trace_header read_trace_header(const std::string &path) {
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  if (!file) {
+    throw std::runtime_error{"cannot open trace file " + path};
+  }
+
+  trace_header header;
+  bool ok = std::fread(&header, sizeof(header), 1, file) == 1;
+  std::fclose(file);
+
+  if (!ok || header.magic_ != trace_header::trace_magic) {
+    throw std::runtime_error{"not a trace file: " + path};
+  }
+
+  return header;
+}
+
+/**
+ * Streaming reader of trace files written by trace_observer.
+ *
+ * @tparam Time Type used for simulation time. Must match the time type the
+ * trace was written with.
+ */
+template <typename Time = double> class trace_reader {
+public:
+  /// Type of the records.
+  using record_type = trace_record<Time>;
+
+  /**
+   * Constructor. Throws std::runtime_error if the file cannot be read or
+   * does not match the time type.
+   *
+   * @param path Path of the trace file.
+   * @param buffer_size Number of records read at once.
+   */
+  explicit trace_reader(const std::string &path,
+                        std::size_t buffer_size = std::size_t{1} << 16)
+      : file_{std::fopen(path.c_str(), "rb")} {
+    if (!file_) {
+      throw std::runtime_error{"cannot open trace file " + path};
+    }
+
+    trace_header header;
+    if (std::fread(&header, sizeof(header), 1, file_) != 1 ||
+        header.magic_ != trace_header::trace_magic) {
+      std::fclose(file_);
+      throw std::runtime_error{"not a trace file: " + path};
+    }
+
+    if (header != trace_header::make<Time>()) {
+      std::fclose(file_);
+      throw std::runtime_error{"unsupported trace format: " + path};
+    }
+
+    buffer_.resize(buffer_size);
+  }
+
+  /// Destructor. Closes the file.
+  ~trace_reader() { std::fclose(file_); }
+
+  trace_reader(const trace_reader &) = delete;
+  trace_reader &operator=(const trace_reader &) = delete;
+
+  /**
+   * Read the next record.
+   *
+   * @param record Record to read into.
+   * @return Whether a record was read. False at the end of the trace.
+   */
+  bool next(record_type &record) {
+    if (pos_ == end_) {
+      end_ = std::fread(buffer_.data(), sizeof(record_type), buffer_.size(),
+                        file_);
+      pos_ = 0;
+      if (end_ == 0) {
+        return false;
+      }
+    }
+
+    record = buffer_[pos_++];
+    ++n_read_;
+    return true;
+  }
+
+  /// @return Number of records read so far.
+  std::uint64_t n_read() const { return n_read_; }
+
+  /**
+   * Call a function with each remaining record.
+   *
+   * @tparam F Type of the function.
+   * @param f Function.
+   */
+  template <typename F> void for_each(F &&f) {
+    record_type record{};
+    while (next(record)) {
+      f(record);
+    }
+  }
+
+private:
+  /// Trace file.
+  std::FILE *file_;
+
+  /// Buffer of records read from the file.
+  std::vector<record_type> buffer_;
+
+  /// Index of the next record in the buffer.
+  std::size_t pos_ = 0;
+
+  /// Number of valid records in the buffer.
+  std::size_t end_ = 0;
+
+  /// Number of records read so far.
+  std::uint64_t n_read_ = 0;
+};
+
+/**
+ * Compare two traces, for example of two runs of a model which should behave
+ * the same.
+ *
+ * @tparam Time Type used for simulation time.
+ * @param path_a Path of the first trace file.
+ * @param path_b Path of the second trace file.
+ * @return Index of the first record which differs, or which only exists in
+ * one trace, or no value if the traces are equal.
+ */
+template <typename Time = double>
+std::optional<std::uint64_t> first_difference(const std::string &path_a,
+                                              const std::string &path_b) {
+  trace_reader<Time> a{path_a};
+  trace_reader<Time> b{path_b};
+
+  trace_record<Time> record_a{};
+  trace_record<Time> record_b{};
+  for (std::uint64_t i = 0;; ++i) {
+    bool has_a = a.next(record_a);
+    bool has_b = b.next(record_b);
+
+    if (!has_a && !has_b) {
+      return std::nullopt;
+    }
+
+    if (has_a != has_b || record_a != record_b) {
+      return i;
+    }
+  }
+}
+} // namespace simcpp20
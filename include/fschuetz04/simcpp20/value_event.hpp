@@ -4,28 +4,31 @@
 #pragma once
 
 #include <cassert>   // assert
-#include <coroutine> // std::suspend_never
-#include <utility>   // std::forward, std::exchange
+#include <coroutine> // std::coroutine_handle
+#include <new>       // ::new
+#include <optional>  // std::optional
+#include <utility>   // std::forward, std::move
+
+#include "pool.hpp"
 
 namespace simcpp20 {
 /**
  * One event with a value.
  *
- * @tparam Time Type used for simulation time.
  * @tparam Value Type of the value.
+ * @tparam Simulation Type of the simulation the event belongs to.
  */
-template <typename Value, class Time = double>
-class value_event : public event<Time> {
+template <typename Value, typename Simulation>
+class basic_value_event : public basic_event<Simulation> {
+  using base = basic_event<Simulation>;
+
 public:
   /**
    * Constructor.
    *
    * @param simulation Reference to the simulation.
    */
-  explicit value_event(simulation<Time> &sim) : event<Time> {
-    std::make_shared<data>(sim)
-  }
-  {}
+  explicit basic_value_event(Simulation &sim) : base{make_data(sim)} {}
 
   /**
    * Set the event state to triggered, and schedule it to be processed
@@ -37,14 +40,14 @@ public:
    * @param args Arguments to construct the event value with.
    */
   template <typename... Args> void trigger(Args &&...args) const {
-    assert(event<Time>::data_);
+    assert(base::data_);
 
-    if (!event<Time>::pending()) {
+    if (!base::pending()) {
       return;
     }
 
     set_value(std::forward<Args>(args)...);
-    event<Time>::trigger();
+    base::trigger();
   }
 
   /**
@@ -55,20 +58,74 @@ public:
    * @return Value of the event.
    */
   const Value &await_resume() {
-    assert(event<Time>::data_);
+    assert(base::data_);
 
-    event<Time>::await_resume();
+    base::await_resume();
     return value();
   }
 
   /// @return Value of the event.
   const Value &value() const {
-    assert(event<Time>::data_);
+    assert(base::data_);
+    return *value_data().value_;
+  }
 
-    auto casted_data = static_pointer_cast<data>(event<Time>::data_);
-    return *casted_data->value_;
+  /**
+   * Move the value out of the event. Afterwards, the value of the event is in
+   * a moved-from state, so this is only meant for the single consumer of the
+   * event.
+   *
+   * @return Value of the event.
+   */
+  Value take_value() const {
+    assert(base::data_);
+    return std::move(*value_data().value_);
   }
 
+  /// Awaitable resuming with the value moved out of the event.
+  class take_awaiter {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param ev Event to await.
+     */
+    explicit take_awaiter(const basic_value_event &ev) : ev_{ev} {}
+
+    /// @return Whether the event is processed.
+    bool await_ready() const { return ev_.await_ready(); }
+
+    /**
+     * @tparam Promise Promise type of the coroutine.
+     * @param handle Coroutine handle.
+     */
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) {
+      ev_.await_suspend(handle);
+    }
+
+    /// @return Value moved out of the event.
+    Value await_resume() {
+      ev_.base::await_resume();
+      return ev_.take_value();
+    }
+
+  private:
+    /// Event to await.
+    basic_value_event ev_;
+  };
+
+  /**
+   * Await the event and move its value out instead of copying it:
+   *
+   *     auto parts = co_await produce_parts(sim).take();
+   *
+   * Only meant for the single consumer of the event, see take_value.
+   *
+   * @return Awaitable resuming with the value moved out of the event.
+   */
+  take_awaiter take() const { return take_awaiter{*this}; }
+
   /**
    * Alias for simulation::any_of.
    *
@@ -76,14 +133,13 @@ public:
    * @return New pending event which is triggered when this event or the other
    * event is processed.
    */
-  value_event<Value, Time>
-  operator|(const value_event<Value, Time> &other) const {
-    assert(event<Time>::data_);
-    return event<Time>::data_->sim_.template any_of<Value>(*this, other);
+  basic_value_event operator|(const basic_value_event &other) const {
+    assert(base::data_);
+    return base::data_->sim_.template any_of<Value>(*this, other);
   }
 
   /// Promise type for a coroutine returning a value event.
-  class promise_type : public event<Time>::generic_promise_type {
+  class promise_type : public base::generic_promise_type {
   public:
     using handle_type = std::coroutine_handle<promise_type>;
 
@@ -95,9 +151,9 @@ public:
      * @param sim Reference to the simulation.
      */
     template <typename... Args>
-    explicit promise_type(simulation<Time> &sim, Args &&...)
-        : event<Time>::generic_promise_type{sim,
-                                            handle_type::from_promise(*this)},
+    explicit promise_type(Simulation &sim, Args &&...)
+        : base::generic_promise_type{sim, handle_type::from_promise(*this),
+                                     ev_},
           ev_{sim} {}
 
     /**
@@ -110,9 +166,9 @@ public:
      * @param sim Reference to the simulation.
      */
     template <typename Class, typename... Args>
-    explicit promise_type(Class &&, simulation<Time> &sim, Args &&...)
-        : event<Time>::generic_promise_type{sim,
-                                            handle_type::from_promise(*this)},
+    explicit promise_type(Class &&, Simulation &sim, Args &&...)
+        : base::generic_promise_type{sim, handle_type::from_promise(*this),
+                                     ev_},
           ev_{sim} {}
 
     /**
@@ -127,8 +183,8 @@ public:
      */
     template <typename Class, typename... Args>
     explicit promise_type(Class &&c, Args &&...)
-        : event<Time>::generic_promise_type{c.sim,
-                                            handle_type::from_promise(*this)},
+        : base::generic_promise_type{c.sim, handle_type::from_promise(*this),
+                                     ev_},
           ev_{c.sim} {}
 
 #ifdef __INTELLISENSE__
@@ -136,57 +192,106 @@ public:
     promise_type();
 #endif
 
-    /// @return Event associated with the process.
-    const event<Time> &process_event() const override { return ev_; }
-
     /**
      * Called to get the return value of the coroutine function.
      *
      * @return Value event associated with the coroutine. This event is
      * triggered when the coroutine returns with the value it returns.
      */
-    value_event<Value, Time> get_return_object() const { return ev_; }
+    basic_value_event get_return_object() const { return ev_; }
 
     /**
-     * Called when the coroutine returns. Trigger the event associated with the
-     * coroutine with the value returned by the coroutine.
+     * Called when the coroutine returns. Set the value of the event associated
+     * with the coroutine, which is completed after the coroutine finished, see
+     * generic_promise_type::final_suspend.
      *
      * @tparam Types of arguments to construct the return value with.
      * @param Arguments to construct the return value with.
      */
-    template <typename... Args> void return_value(Args &&...args) const {
-      ev_.trigger(std::forward<Args>(args)...);
+    template <typename... Args> void return_value(Args &&...args) {
+      this->sim_.observer_.on_process_end(this->id_);
+      if (ev_.pending()) {
+        ev_.set_value(std::forward<Args>(args)...);
+      }
+      this->returned_ = true;
     }
 
     /**
      * Value event associated with the coroutine. This event is triggered when
      * the coroutine returns with the value the coroutine returns.
      */
-    value_event<Value, Time> ev_;
+    basic_value_event ev_;
   };
 
 private:
   /// Shared data of the event.
-  class data : public event<Time>::data {
+  class data : public base::data {
   public:
-    using event<Time>::data::data;
+    /**
+     * Constructor.
+     *
+     * @param sim Reference to the simulation.
+     */
+    explicit data(Simulation &sim) : base::data{sim, &destroy_value_data} {}
+
+    /**
+     * Destroy shared data of this type and release its memory.
+     *
+     * @param d Shared data, which must be of this type.
+     */
+    static void destroy_value_data(typename base::data *d) {
+      auto self = static_cast<data *>(d);
+      if constexpr (in_pool) {
+        auto &sim_pool = self->sim_.pool_;
+        self->~data();
+        sim_pool.deallocate(self, sizeof(data), memory_kind::events);
+      } else {
+        delete self;
+      }
+    }
 
-    /// Destructor.
-    ~data() override {}
+    /// Whether the shared data is allocated from the pool of the simulation.
+    static constexpr bool in_pool = alignof(std::optional<Value>) <=
+                                    pool::granularity;
 
-    /// Value of the event.
-    std::shared_ptr<Value> value_;
+    /// Value of the event, stored inline.
+    std::optional<Value> value_;
   };
 
+  /**
+   * @param sim Reference to the simulation.
+   * @return New shared data, allocated from the pool of the simulation unless
+   * the value is over-aligned.
+   */
+  static data *make_data(Simulation &sim) {
+    if constexpr (data::in_pool) {
+      return ::new (sim.pool_.allocate(sizeof(data), memory_kind::events))
+          data{sim};
+    } else {
+      return new data{sim};
+    }
+  }
+
+  /// @return Shared data of the event.
+  data &value_data() const { return static_cast<data &>(*base::data_); }
+
   /**
    * @tparam Args Types of arguments to construct the event value with.
    * @param args Arguments to construct the event value with.
    */
   template <typename... Args> void set_value(Args &&...args) const {
-    auto casted_data = static_pointer_cast<data>(event<Time>::data_);
-    casted_data->value_ = std::make_shared<Value>(std::forward<Args>(args)...);
+    value_data().value_.emplace(std::forward<Args>(args)...);
   }
 
-  friend class simulation<Time>;
+  friend Simulation;
 };
+
+/**
+ * One event with a value of a simulation using the default queue.
+ *
+ * @tparam Value Type of the value.
+ * @tparam Time Type used for simulation time.
+ */
+template <typename Value, typename Time = double>
+using value_event = basic_value_event<Value, simulation<Time>>;
 } // namespace simcpp20
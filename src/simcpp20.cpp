@@ -0,0 +1,26 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+// Explicit instantiations for the simulations with double and std::uint64_t
+// time, declared with extern template if FSCHUETZ04_SIMCPP20_EXTERN_TEMPLATES
+// is defined. Compiled into the fschuetz04::simcpp20_compiled target.
+
+#include <cstdint> // std::uint64_t
+
+#include "fschuetz04/simcpp20.hpp"
+
+namespace simcpp20 {
+template class simulation<double>;
+template class basic_event<simulation<double>>;
+template class basic_timer<simulation<double>>;
+template class basic_resource<simulation<double>>;
+template class basic_priority_resource<simulation<double>>;
+template class basic_preemptive_resource<simulation<double>>;
+
+template class simulation<std::uint64_t>;
+template class basic_event<simulation<std::uint64_t>>;
+template class basic_timer<simulation<std::uint64_t>>;
+template class basic_resource<simulation<std::uint64_t>>;
+template class basic_priority_resource<simulation<std::uint64_t>>;
+template class basic_preemptive_resource<simulation<std::uint64_t>>;
+} // namespace simcpp20
@@ -1,11 +1,28 @@
 // Copyright © 2021 Felix Schütz.
 // Licensed under the MIT license. See the LICENSE file for details.
 
+#include "catch2/catch_template_test_macros.hpp"
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/generators/catch_generators.hpp"
 #include "fschuetz04/simcpp20.hpp"
 
-#include <string> // std::string
+#include <any>         // std::any_cast
+#include <array>       // std::array
+#include <chrono>      // std::chrono
+#include <cmath>       // std::abs
+#include <cstdint>     // std::uint64_t
+#include <filesystem>  // std::filesystem
+#include <limits>      // std::numeric_limits
+#include <memory>      // std::make_unique, std::unique_ptr
+#include <random>      // std::mt19937_64, std::uniform_int_distribution
+#include <set>         // std::set
+#include <span>        // std::span
+#include <stdexcept>   // std::runtime_error
+#include <string>      // std::string
+#include <thread>      // std::thread
+#include <type_traits> // std::is_floating_point_v, std::is_polymorphic_v
+#include <utility>     // std::declval, std::pair
+#include <vector>      // std::vector
 
 simcpp20::event<> awaiter(simcpp20::simulation<> &sim, simcpp20::event<> ev,
                           double expected_time, bool &finished) {
@@ -170,3 +187,1905 @@ TEST_CASE("all_of") {
     REQUIRE(finished);
   }
 }
+
+TEST_CASE("pool reuses freed blocks of the same size class") {
+  simcpp20::pool pool;
+
+  auto a = pool.allocate(24);
+  pool.deallocate(a, 24);
+  auto b = pool.allocate(20);
+  REQUIRE(a == b);
+
+  auto c = pool.allocate(24);
+  REQUIRE(c != b);
+
+  auto large = pool.allocate(simcpp20::pool::max_size + 1);
+  pool.deallocate(large, simcpp20::pool::max_size + 1);
+  pool.deallocate(b, 20);
+  pool.deallocate(c, 24);
+}
+
+TEST_CASE("events can be created and destroyed repeatedly") {
+  simcpp20::simulation<> sim;
+
+  for (int i = 0; i < 10000; ++i) {
+    sim.timeout(1);
+    sim.timeout<std::string>(1, "value");
+  }
+
+  sim.run();
+
+  REQUIRE(sim.now() == 1);
+}
+
+TEST_CASE("copies, moves and assignments of events share their state") {
+  simcpp20::simulation<> sim;
+
+  auto a = sim.event();
+  auto b = a;
+  REQUIRE(b == a);
+  REQUIRE(std::hash<simcpp20::event<>>{}(b) ==
+          std::hash<simcpp20::event<>>{}(a));
+
+  auto c = sim.event();
+  c = b;
+  REQUIRE(c == a);
+
+  auto &self = c;
+  c = self;
+  REQUIRE(c == a);
+
+  auto d = std::move(b);
+  b = sim.timeout<std::string>(1, "value");
+  REQUIRE(d == a);
+  REQUIRE(!(b == a));
+
+  d.trigger();
+  sim.run();
+  REQUIRE(a.processed());
+  REQUIRE(c.processed());
+  REQUIRE(b.processed());
+}
+
+TEST_CASE("event handles are a single pointer without a vtable") {
+  STATIC_REQUIRE(sizeof(simcpp20::event<>) == sizeof(void *));
+  STATIC_REQUIRE(sizeof(simcpp20::value_event<std::string>) == sizeof(void *));
+  STATIC_REQUIRE(!std::is_polymorphic_v<simcpp20::event<>>);
+  STATIC_REQUIRE(
+      !std::is_polymorphic_v<simcpp20::event<>::generic_promise_type>);
+}
+
+TEST_CASE("events scheduled without delay keep insertion order") {
+  simcpp20::simulation<> sim;
+  std::vector<int> order;
+
+  auto ev_a = sim.timeout(1);
+  auto ev_b = sim.timeout(1);
+  auto ev_c = sim.event();
+  ev_a.add_callback([&](const auto &) {
+    order.push_back(1);
+    ev_c.trigger();
+  });
+  ev_b.add_callback([&](const auto &) { order.push_back(2); });
+  ev_c.add_callback([&](const auto &) { order.push_back(3); });
+
+  sim.run();
+
+  REQUIRE(order == std::vector<int>{1, 2, 3});
+  REQUIRE(sim.now() == 1);
+}
+
+template <typename Time> struct basic_queue_item {
+  Time time_;
+  std::uint64_t id_;
+
+  bool operator>(const basic_queue_item &other) const {
+    if (time_ != other.time_) {
+      return time_ > other.time_;
+    }
+
+    return id_ > other.id_;
+  }
+};
+
+using queue_item = basic_queue_item<double>;
+using int_queue_item = basic_queue_item<std::uint64_t>;
+
+/**
+ * @return Time after a random delay, in quarters for floating point time to
+ * create both equal and distinct times.
+ */
+template <typename Time> Time queue_time(Time now, int delay) {
+  if constexpr (std::is_floating_point_v<Time>) {
+    return now + delay / 4.;
+  } else {
+    return now + static_cast<Time>(delay);
+  }
+}
+
+TEMPLATE_TEST_CASE("queues pop items in (time, id) order", "",
+                   simcpp20::binary_heap<queue_item>,
+                   simcpp20::quaternary_heap<queue_item>,
+                   simcpp20::calendar_queue<queue_item>,
+                   simcpp20::radix_heap<int_queue_item>,
+                   simcpp20::calendar_queue<int_queue_item>) {
+  using item_type =
+      std::remove_cvref_t<decltype(std::declval<const TestType &>().top())>;
+  using time_type = decltype(item_type::time_);
+
+  TestType queue;
+  std::set<std::pair<time_type, std::uint64_t>> expected;
+  std::mt19937_64 gen{42};
+  std::uniform_int_distribution<int> delay_dist{0, 50};
+  std::uniform_int_distribution<int> n_push_dist{0, 3};
+
+  time_type now = 0;
+  std::uint64_t next_id = 0;
+  for (int i = 0; i < 4000; ++i) {
+    // grow the queue during the first half and shrink it afterwards
+    int n_push = i < 2000 ? n_push_dist(gen) : n_push_dist(gen) / 2;
+
+    // the simulation looks at the first item before pushing earlier ones
+    if (!queue.empty()) {
+      REQUIRE(queue.top().id_ == expected.begin()->second);
+    }
+
+    for (int j = 0; j < n_push; ++j) {
+      auto time = queue_time(now, delay_dist(gen));
+      queue.push(item_type{time, next_id});
+      expected.emplace(time, next_id);
+      ++next_id;
+    }
+
+    if (i % 1000 == 250) {
+      // more items than queued are inserted by rebuilding the queue
+      std::vector<item_type> items;
+      for (int j = 0; j < (i < 2000 ? 2000 : 3); ++j) {
+        auto time = queue_time(now, delay_dist(gen));
+        items.push_back(item_type{time, next_id});
+        expected.emplace(time, next_id);
+        ++next_id;
+      }
+      queue.push_many(std::move(items));
+    }
+
+    if (i % 1000 == 500) {
+      auto odd = [](const item_type &item) { return item.id_ % 2 == 1; };
+      auto n = std::erase_if(expected, [](const auto &entry) {
+        return entry.second % 2 == 1;
+      });
+      REQUIRE(queue.erase_if(odd) == n);
+    }
+
+    if (queue.empty()) {
+      continue;
+    }
+
+    REQUIRE(queue.size() == expected.size());
+    REQUIRE(queue.top().id_ == expected.begin()->second);
+
+    auto item = queue.pop();
+    REQUIRE(item.time_ == expected.begin()->first);
+    REQUIRE(item.id_ == expected.begin()->second);
+    expected.erase(expected.begin());
+    now = item.time_;
+  }
+}
+
+TEST_CASE("calendar_queue orders huge and infinite times") {
+  simcpp20::calendar_queue<queue_item> queue;
+  auto inf = std::numeric_limits<double>::infinity();
+  std::vector<double> times = {inf, 1e300, 2, inf, 1e20, 1, 1e300};
+
+  std::uint64_t id = 0;
+  for (auto time : times) {
+    queue.push(queue_item{time, id++});
+  }
+
+  // enough items to resize the buckets, which samples the earliest times
+  for (int i = 0; i < 64; ++i) {
+    queue.push(queue_item{inf, id++});
+  }
+
+  std::vector<std::pair<double, std::uint64_t>> popped;
+  while (popped.size() < 8) {
+    auto item = queue.pop();
+    popped.emplace_back(item.time_, item.id_);
+  }
+
+  std::vector<std::pair<double, std::uint64_t>> expected = {
+      {1, 5}, {2, 2}, {1e20, 4}, {1e300, 1},
+      {1e300, 6}, {inf, 0}, {inf, 3}, {inf, 7}};
+  REQUIRE(popped == expected);
+}
+
+template <typename Simulation>
+simcpp20::basic_event<Simulation>
+recorder(Simulation &sim, int id, typename Simulation::time_type delay,
+         std::vector<int> &order) {
+  for (int i = 0; i < 3; ++i) {
+    co_await sim.timeout(delay);
+    order.push_back(id);
+  }
+}
+
+template <typename Simulation> std::vector<int> record_order() {
+  Simulation sim;
+  std::vector<int> order;
+
+  for (int id = 0; id < 100; ++id) {
+    recorder(sim, id, (id * 7) % 5, order);
+  }
+
+  sim.run();
+
+  return order;
+}
+
+TEST_CASE("the order of events does not depend on the queue") {
+  auto expected = record_order<simcpp20::simulation<>>();
+
+  using quaternary_sim =
+      simcpp20::simulation<double, simcpp20::quaternary_heap>;
+  REQUIRE(record_order<quaternary_sim>() == expected);
+
+  using calendar_sim = simcpp20::simulation<double, simcpp20::calendar_queue>;
+  REQUIRE(record_order<calendar_sim>() == expected);
+
+  using radix_sim = simcpp20::simulation<std::uint64_t>;
+  REQUIRE(record_order<radix_sim>() == expected);
+
+  using int_heap_sim = simcpp20::simulation<long, simcpp20::binary_heap>;
+  REQUIRE(record_order<int_heap_sim>() == expected);
+}
+
+struct member_process {
+  simcpp20::simulation<> &sim;
+  int n_finished = 0;
+
+  simcpp20::event<> run(double delay) {
+    co_await sim.timeout(delay);
+    ++n_finished;
+  }
+};
+
+TEST_CASE("lambdas and member functions can be processes") {
+  simcpp20::simulation<> sim;
+  member_process member{sim};
+  int n_lambda_finished = 0;
+  auto lambda = [&](simcpp20::simulation<> &sim,
+                    double delay) -> simcpp20::event<> {
+    co_await sim.timeout(delay);
+    ++n_lambda_finished;
+  };
+
+  for (int i = 0; i < 1000; ++i) {
+    member.run(i % 3);
+    lambda(sim, i % 3);
+  }
+
+  sim.run();
+
+  REQUIRE(member.n_finished == 1000);
+  REQUIRE(n_lambda_finished == 1000);
+}
+
+struct destruction_counter {
+  int &n_destroyed;
+
+  ~destruction_counter() { ++n_destroyed; }
+};
+
+simcpp20::event<> never_finishing(simcpp20::simulation<> &sim,
+                                  int &n_destroyed) {
+  destruction_counter counter{n_destroyed};
+  co_await sim.event();
+}
+
+TEST_CASE("pending processes are destroyed with the simulation") {
+  int n_destroyed = 0;
+
+  {
+    simcpp20::simulation<> sim;
+    for (int i = 0; i < 100; ++i) {
+      never_finishing(sim, n_destroyed);
+    }
+
+    sim.run();
+
+    REQUIRE(n_destroyed == 0);
+  }
+
+  REQUIRE(n_destroyed == 100);
+}
+
+simcpp20::event<> appender(simcpp20::simulation<> &sim, int id,
+                           std::vector<int> &order) {
+  order.push_back(id);
+  co_await sim.timeout(0);
+  order.push_back(id + 10);
+}
+
+simcpp20::event<> spawner(simcpp20::simulation<> &sim,
+                          std::vector<int> &order) {
+  co_await sim.timeout(1);
+  appender(sim, 1, order);
+  sim.timeout(0).add_callback([&](const auto &) { order.push_back(2); });
+  appender(sim, 3, order);
+  order.push_back(0);
+}
+
+TEST_CASE("processes start at the current time in creation order") {
+  simcpp20::simulation<> sim;
+  std::vector<int> order;
+
+  spawner(sim, order);
+  sim.run();
+
+  REQUIRE(order == std::vector<int>{0, 1, 2, 3, 11, 13});
+  REQUIRE(sim.now() == 1);
+}
+
+struct copy_counter {
+  explicit copy_counter(int &n_copies) : n_copies{&n_copies} {}
+
+  copy_counter(const copy_counter &other) : n_copies{other.n_copies} {
+    ++*n_copies;
+  }
+
+  copy_counter(copy_counter &&other) noexcept = default;
+
+  int *n_copies;
+};
+
+simcpp20::value_event<copy_counter>
+counter_producer(simcpp20::simulation<> &sim, int &n_copies) {
+  co_await sim.timeout(1);
+  copy_counter counter{n_copies};
+  co_return std::move(counter);
+}
+
+simcpp20::event<> counter_consumer(simcpp20::simulation<> &sim, int &n_copies,
+                                   bool &finished) {
+  auto counter = co_await counter_producer(sim, n_copies).take();
+  REQUIRE(counter.n_copies == &n_copies);
+  finished = true;
+}
+
+TEST_CASE("values can be moved out of value events") {
+  simcpp20::simulation<> sim;
+  int n_copies = 0;
+  bool finished = false;
+
+  counter_consumer(sim, n_copies, finished);
+  sim.run();
+
+  REQUIRE(finished);
+  REQUIRE(n_copies == 0);
+}
+
+simcpp20::value_event<std::unique_ptr<int>>
+unique_producer(simcpp20::simulation<> &sim) {
+  co_await sim.timeout(1);
+  co_return std::make_unique<int>(42);
+}
+
+TEST_CASE("value events support move-only values") {
+  simcpp20::simulation<> sim;
+
+  auto ev = unique_producer(sim);
+  sim.run();
+
+  REQUIRE(*ev.value() == 42);
+  auto value = ev.take_value();
+  REQUIRE(*value == 42);
+  REQUIRE(ev.value() == nullptr);
+}
+
+TEST_CASE("small_vector moves its elements to the heap when growing") {
+  simcpp20::small_vector<std::string, 1> vec;
+  vec.push_back("a");
+  vec.emplace_back(2, 'b');
+  vec.emplace_back("c");
+
+  REQUIRE(vec.size() == 3);
+  REQUIRE(vec[0] == "a");
+  REQUIRE(vec[1] == "bb");
+  REQUIRE(vec[2] == "c");
+
+  auto moved = std::move(vec);
+  REQUIRE(vec.empty());
+  REQUIRE(moved.size() == 3);
+  REQUIRE(moved[2] == "c");
+}
+
+TEST_CASE("callback stores small and large callables") {
+  int sum = 0;
+  simcpp20::callback<void(int)> small = [&sum](int n) { sum += n; };
+  std::array<int, 16> values{};
+  values.back() = 100;
+  simcpp20::callback<void(int)> large = [&sum, values](int n) {
+    sum += n * values.back();
+  };
+
+  small(1);
+  large(2);
+  REQUIRE(sum == 201);
+
+  auto moved_small = std::move(small);
+  auto moved_large = std::move(large);
+  moved_small(3);
+  moved_large(4);
+  REQUIRE(sum == 604);
+}
+
+TEST_CASE("events accept move-only callbacks") {
+  simcpp20::simulation<> sim;
+  int value = 0;
+
+  auto ptr = std::make_unique<int>(42);
+  sim.timeout(1).add_callback(
+      [&value, ptr = std::move(ptr)](const auto &) { value = *ptr; });
+  sim.run();
+
+  REQUIRE(value == 42);
+}
+
+TEST_CASE("any_of and all_of over ranges") {
+  simcpp20::simulation<> sim;
+
+  std::vector<simcpp20::event<>> evs;
+  for (int i = 0; i < 100; ++i) {
+    evs.push_back(sim.timeout(100 - i));
+  }
+
+  SECTION("any_of reports the index of the first processed event") {
+    auto ev = sim.any_of(evs);
+    sim.run();
+
+    REQUIRE(ev.processed());
+    REQUIRE(ev.value() == 99);
+  }
+
+  SECTION("all_of is triggered when all events are processed") {
+    auto ev = sim.all_of(evs);
+    bool finished = false;
+    awaiter(sim, ev, 100, finished);
+    sim.run();
+
+    REQUIRE(finished);
+  }
+
+  SECTION("all_of accepts spans and already processed events") {
+    sim.run_until(50);
+    auto ev = sim.all_of(std::span<const simcpp20::event<>>{evs}.first(60));
+    sim.run();
+
+    REQUIRE(ev.processed());
+    REQUIRE(sim.now() == 100);
+  }
+
+  SECTION("all_of of an empty range is triggered immediately") {
+    auto ev = sim.all_of(std::vector<simcpp20::event<>>{});
+    REQUIRE(ev.triggered());
+  }
+}
+
+TEST_CASE("all_of of processed events is triggered") {
+  simcpp20::simulation<> sim;
+  auto ev_a = sim.timeout(1);
+  auto ev_b = sim.timeout(1);
+  sim.run();
+
+  auto ev = sim.all_of(ev_a, ev_b);
+  REQUIRE(ev.triggered());
+}
+
+using observed_sim = simcpp20::simulation<double, simcpp20::binary_heap,
+                                          simcpp20::counting_observer<>>;
+
+observed_sim::event_type observed_process(observed_sim &sim) {
+  co_await sim.timeout(1);
+  co_await sim.timeout(1);
+}
+
+TEST_CASE("counting_observer counts what happens in a simulation") {
+  observed_sim sim;
+  observed_process(sim);
+  observed_process(sim).abort();
+  sim.timeout(5).abort();
+  sim.run();
+
+  auto &observer = sim.observer();
+  REQUIRE(observer.n_scheduled_ == 6);
+  REQUIRE(observer.n_steps_ == 5);
+  REQUIRE(observer.n_processed_ == 3);
+  REQUIRE(observer.n_resumed_ == 2);
+  REQUIRE(observer.n_aborted_ == 1);
+  REQUIRE(observer.n_started_ == 1);
+  REQUIRE(observer.n_finished_ == 1);
+  REQUIRE(observer.burst_sizes_[1] == 1);
+  REQUIRE(observer.burst_sizes_[2] == 1);
+}
+
+using traced_sim = simcpp20::simulation<double, simcpp20::binary_heap,
+                                        simcpp20::trace_observer<>>;
+
+traced_sim::event_type traced_process(traced_sim &sim, double delay) {
+  co_await sim.timeout(1);
+  co_await sim.timeout(delay);
+}
+
+void write_trace(const std::string &path, double delay) {
+  traced_sim sim;
+  sim.observer().open(path);
+  traced_process(sim, 2);
+  traced_process(sim, delay);
+  sim.run();
+}
+
+TEST_CASE("trace_observer writes a trace which can be read and compared") {
+  auto dir = std::filesystem::temp_directory_path();
+  auto a = (dir / "simcpp20_trace_a.bin").string();
+  auto b = (dir / "simcpp20_trace_b.bin").string();
+  auto c = (dir / "simcpp20_trace_c.bin").string();
+  write_trace(a, 3);
+  write_trace(b, 3);
+  write_trace(c, 4);
+
+  simcpp20::trace_reader<> reader{a};
+  std::vector<simcpp20::trace_record<double>> records;
+  reader.for_each([&](const auto &record) { records.push_back(record); });
+
+  using k = simcpp20::trace_kind;
+  REQUIRE(records.size() == 22);
+  REQUIRE(records[0] == simcpp20::trace_record<double>{0, 0, k::schedule, 0});
+  REQUIRE(records[2] == simcpp20::trace_record<double>{0, 0, k::start, 0});
+  REQUIRE(records[3] == simcpp20::trace_record<double>{1, 2, k::schedule, 0});
+  REQUIRE(records[6] == simcpp20::trace_record<double>{1, 2, k::process, 1});
+  REQUIRE(records[7] == simcpp20::trace_record<double>{1, 0, k::resume, 0});
+  REQUIRE(records[19] == simcpp20::trace_record<double>{4, 1, k::end, 0});
+
+  REQUIRE(!simcpp20::first_difference(a, b));
+  REQUIRE(simcpp20::first_difference(a, c) == 11);
+
+  std::filesystem::remove(a);
+  std::filesystem::remove(b);
+  std::filesystem::remove(c);
+}
+
+simcpp20::event<> replication_process(simcpp20::simulation<> &sim,
+                                      std::size_t i, std::size_t &n) {
+  for (std::size_t j = 0; j < i; ++j) {
+    co_await sim.timeout(1);
+    ++n;
+  }
+}
+
+TEST_CASE("run_replications runs independent simulations in parallel") {
+  auto model = [](std::size_t i) {
+    simcpp20::simulation<> sim;
+    std::size_t n = 0;
+    replication_process(sim, i, n);
+    sim.run();
+    return std::pair{sim.now(), n};
+  };
+
+  SECTION("results are ordered by replication") {
+    auto results = simcpp20::run_replications(100, model, 8);
+
+    REQUIRE(results.size() == 100);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+      REQUIRE(results[i].first == static_cast<double>(i));
+      REQUIRE(results[i].second == i);
+    }
+  }
+
+  SECTION("results are reduced in the order of their replication") {
+    auto order = simcpp20::run_replications(
+        10, model, std::string{},
+        [](std::string s, auto result) {
+          return s + std::to_string(result.second);
+        },
+        4);
+
+    REQUIRE(order == "0123456789");
+  }
+
+  SECTION("the first exception is rethrown") {
+    auto throwing = [](std::size_t i) {
+      if (i == 3) {
+        throw std::runtime_error{"replication failed"};
+      }
+      return i;
+    };
+
+    REQUIRE_THROWS_AS(simcpp20::run_replications(10, throwing, 4),
+                      std::runtime_error);
+  }
+}
+
+simcpp20::event<> pdes_sender(simcpp20::simulation<> &sim,
+                              simcpp20::channel<int> &out, int n) {
+  for (int i = 0; i < n; ++i) {
+    out.send(i);
+    co_await sim.timeout(0.5);
+  }
+}
+
+simcpp20::event<> pdes_forwarder(simcpp20::simulation<> &,
+                                 simcpp20::channel<int> &in,
+                                 simcpp20::channel<int> &out, int n) {
+  for (int i = 0; i < n; ++i) {
+    out.send(10 * co_await in.receive(), 2);
+  }
+}
+
+simcpp20::event<> pdes_receiver(simcpp20::simulation<> &sim,
+                                simcpp20::channel<int> &in, int n,
+                                std::vector<std::pair<double, int>> &log) {
+  for (int i = 0; i < n; ++i) {
+    auto value = co_await in.receive();
+    log.emplace_back(sim.now(), value);
+  }
+}
+
+TEST_CASE("parallel_simulation passes messages between simulations") {
+  simcpp20::parallel_simulation<> psim{3};
+  auto &a_to_b = psim.connect<int>(0, 1, 1);
+  auto &b_to_c = psim.connect<int>(1, 2, 2);
+  std::vector<std::pair<double, int>> log;
+
+  pdes_sender(psim[0], a_to_b, 5);
+  pdes_forwarder(psim[1], a_to_b, b_to_c, 5);
+  pdes_receiver(psim[2], b_to_c, 5, log);
+
+  SECTION("run processes all messages") {
+    psim.run();
+
+    std::vector<std::pair<double, int>> expected = {
+        {3, 0}, {3.5, 10}, {4, 20}, {4.5, 30}, {5, 40}};
+    REQUIRE(log == expected);
+  }
+
+  SECTION("run_until stops all simulations at the target time") {
+    psim.run_until(4);
+
+    std::vector<std::pair<double, int>> expected = {{3, 0}, {3.5, 10}};
+    REQUIRE(log == expected);
+    for (std::size_t i = 0; i < psim.size(); ++i) {
+      REQUIRE(psim[i].now() == 4);
+    }
+
+    psim.run();
+    REQUIRE(log.size() == 5);
+  }
+}
+
+simcpp20::event<> resource_user(simcpp20::simulation<> &sim,
+                                simcpp20::resource<> &res, int id,
+                                double patience,
+                                std::vector<std::pair<double, int>> &log) {
+  auto req = res.request();
+  if (!co_await req.wait_for(patience)) {
+    log.emplace_back(sim.now(), -id);
+    co_return;
+  }
+
+  log.emplace_back(sim.now(), id);
+  co_await sim.timeout(2);
+  res.release();
+}
+
+TEST_CASE("resource grants units in FIFO order") {
+  simcpp20::simulation<> sim;
+  simcpp20::resource<> res{sim, 2};
+  std::vector<std::pair<double, int>> log;
+
+  for (int id = 1; id <= 5; ++id) {
+    resource_user(sim, res, id, id == 4 ? 1 : 10, log);
+  }
+
+  sim.run_until(1);
+  REQUIRE(res.available() == 0);
+  REQUIRE(res.n_waiting() == 3);
+
+  sim.run();
+  std::vector<std::pair<double, int>> expected = {
+      {0, 1}, {0, 2}, {1, -4}, {2, 3}, {2, 5}};
+  REQUIRE(log == expected);
+  REQUIRE(res.available() == 2);
+  REQUIRE(res.n_waiting() == 0);
+}
+
+TEST_CASE("requests granted without waiting resume in scheduling order") {
+  simcpp20::simulation<> sim;
+  simcpp20::resource<> res{sim, 2};
+  std::vector<std::pair<double, int>> log;
+
+  resource_user(sim, res, 1, 10, log);
+  sim.timeout(0).add_callback(
+      [&](const auto &) { log.emplace_back(sim.now(), 0); });
+  resource_user(sim, res, 2, 10, log);
+  sim.run_until(1);
+
+  std::vector<std::pair<double, int>> expected = {{0, 0}, {0, 1}, {0, 2}};
+  REQUIRE(log == expected);
+}
+
+simcpp20::event<> holding_user(simcpp20::simulation<> &sim,
+                               simcpp20::resource<> &res) {
+  co_await res.request();
+  co_await sim.timeout(10);
+}
+
+TEST_CASE("a resource can be destroyed while a request waits with a timeout") {
+  simcpp20::simulation<> sim;
+  std::vector<std::pair<double, int>> log;
+
+  auto res = std::make_unique<simcpp20::resource<>>(sim, 1);
+  holding_user(sim, *res);
+  resource_user(sim, *res, 1, 5, log);
+  sim.run_until(1);
+  REQUIRE(res->n_waiting() == 1);
+
+  res.reset();
+  sim.run();
+  REQUIRE(log.empty());
+}
+
+simcpp20::event<> priority_user(simcpp20::simulation<> &sim,
+                                simcpp20::priority_resource<> &res, int id,
+                                int priority, std::vector<int> &log) {
+  co_await res.request(priority);
+  log.push_back(id);
+  co_await sim.timeout(1);
+  res.release();
+}
+
+TEST_CASE("priority_resource grants units in order of priority") {
+  simcpp20::simulation<> sim;
+  simcpp20::priority_resource<> res{sim, 1};
+  std::vector<int> log;
+
+  priority_user(sim, res, 1, 5, log);
+  priority_user(sim, res, 2, 3, log);
+  priority_user(sim, res, 3, 1, log);
+  priority_user(sim, res, 4, 3, log);
+  priority_user(sim, res, 5, 7, log);
+  sim.run();
+
+  REQUIRE(log == std::vector<int>{1, 3, 2, 4, 5});
+}
+
+simcpp20::event<> preemptive_user(simcpp20::simulation<> &sim,
+                                  simcpp20::preemptive_resource<> &res,
+                                  int id, int priority,
+                                  std::vector<std::pair<double, int>> &log) {
+  auto req = res.request(priority);
+  co_await req;
+  log.emplace_back(sim.now(), id);
+
+  co_await (sim.timeout(3) | res.preempted(req));
+  if (res.is_preempted(req)) {
+    log.emplace_back(sim.now(), -id);
+    co_return;
+  }
+
+  res.release(req);
+}
+
+simcpp20::event<> delayed_preemptive_user(
+    simcpp20::simulation<> &sim, simcpp20::preemptive_resource<> &res,
+    int id, int priority, double delay,
+    std::vector<std::pair<double, int>> &log) {
+  co_await sim.timeout(delay);
+  co_await preemptive_user(sim, res, id, priority, log);
+}
+
+TEST_CASE("preemptive_resource takes units away from lower priorities") {
+  simcpp20::simulation<> sim;
+  simcpp20::preemptive_resource<> res{sim, 1};
+  std::vector<std::pair<double, int>> log;
+
+  preemptive_user(sim, res, 1, 5, log);
+  delayed_preemptive_user(sim, res, 2, 1, 1, log);
+  delayed_preemptive_user(sim, res, 3, 5, 2, log);
+  sim.run();
+
+  std::vector<std::pair<double, int>> expected = {
+      {0, 1}, {1, 2}, {1, -1}, {4, 3}};
+  REQUIRE(log == expected);
+  REQUIRE(res.available() == 1);
+}
+
+TEMPLATE_TEST_CASE("events can be scheduled in bulk", "",
+                   simcpp20::simulation<>,
+                   (simcpp20::simulation<double, simcpp20::calendar_queue>),
+                   simcpp20::simulation<std::uint64_t>) {
+  TestType sim;
+  std::vector<std::pair<double, int>> log;
+  auto record = [&](const typename TestType::event_type &ev, int i) {
+    ev.add_callback([&log, &sim, i](const auto &) {
+      log.emplace_back(sim.now(), i);
+    });
+  };
+
+  SECTION("timeouts are processed in the order of their delays and IDs") {
+    record(sim.timeout(1), -1);
+
+    std::vector<typename TestType::time_type> delays = {2, 1, 1, 0, 2};
+    auto evs = sim.timeouts(delays);
+    REQUIRE(evs.size() == delays.size());
+    REQUIRE(sim.size() == 6);
+    for (std::size_t i = 0; i < evs.size(); ++i) {
+      record(evs[i], static_cast<int>(i));
+    }
+
+    sim.run();
+
+    std::vector<std::pair<double, int>> expected = {
+        {0, 3}, {1, -1}, {1, 1}, {1, 2}, {2, 0}, {2, 4}};
+    REQUIRE(log == expected);
+  }
+
+  SECTION("events scheduled again are processed once at their earliest time") {
+    auto a = sim.timeout(5);
+    auto b = sim.event();
+    auto c = sim.timeout(1);
+    record(a, 0);
+    record(b, 1);
+    record(c, 2);
+
+    std::vector<std::pair<typename TestType::time_type,
+                          typename TestType::event_type>>
+        evs = {
+        {3, a}, {1, b}, {2, a}, {4, a}, {2, c}};
+    sim.schedule_many(evs);
+    REQUIRE(sim.size() == 3);
+
+    sim.run();
+
+    std::vector<std::pair<double, int>> expected = {{1, 2}, {1, 1}, {2, 0}};
+    REQUIRE(log == expected);
+  }
+}
+
+TEMPLATE_TEST_CASE("scheduled events can be cancelled and rescheduled", "",
+                   simcpp20::simulation<>,
+                   (simcpp20::simulation<double, simcpp20::calendar_queue>),
+                   simcpp20::simulation<std::uint64_t>) {
+  TestType sim;
+  std::vector<typename TestType::event_type> timeouts;
+  for (int i = 1; i <= 1000; ++i) {
+    timeouts.push_back(sim.timeout(i));
+  }
+
+  SECTION("aborted timeouts are removed from the queue") {
+    for (std::size_t i = 0; i < timeouts.size(); ++i) {
+      if (i % 10 != 0) {
+        timeouts[i].abort();
+      }
+    }
+
+    REQUIRE(sim.size() == 100);
+
+    std::size_t n_steps = 0;
+    while (!sim.empty()) {
+      sim.step();
+      ++n_steps;
+    }
+
+    REQUIRE(n_steps == 100);
+    REQUIRE(sim.now() == 991);
+  }
+
+  SECTION("rescheduled timeouts are processed once at their new time") {
+    auto ev = timeouts[0];
+    bool processed = false;
+    ev.add_callback([&](const auto &) {
+      REQUIRE(!processed);
+      REQUIRE(sim.now() == 1500);
+      processed = true;
+    });
+
+    sim.reschedule(ev, 1500);
+    REQUIRE(sim.size() == 1000);
+
+    sim.run_until(1200);
+    REQUIRE(ev.pending());
+
+    auto later = sim.timeout(1000);
+    sim.reschedule(later, 0);
+    sim.reschedule(ev, 300);
+    REQUIRE(sim.size() == 2);
+
+    sim.step();
+    REQUIRE(later.processed());
+    REQUIRE(sim.now() == 1200);
+
+    sim.run();
+    REQUIRE(processed);
+  }
+
+  SECTION("scheduling an event again does not move it later") {
+    std::vector<std::pair<typename TestType::time_type, int>> log;
+    auto record = [&](int id) {
+      return [&log, &sim, id](const auto &) {
+        log.emplace_back(sim.now(), id);
+      };
+    };
+
+    auto a = sim.timeout(0);
+    a.add_callback(record(1));
+    sim.timeout(0).add_callback(record(2));
+    auto b = sim.timeout(3);
+    b.add_callback(record(3));
+    sim.timeout(3).add_callback(record(4));
+
+    a.trigger();
+    sim.schedule(a);
+    sim.schedule(b, 3);
+    sim.schedule(b, 5);
+    REQUIRE(sim.size() == 1004);
+
+    sim.run_until(4);
+
+    std::vector<std::pair<typename TestType::time_type, int>> expected = {
+        {0, 1}, {0, 2}, {3, 3}, {3, 4}};
+    REQUIRE(log == expected);
+  }
+
+  SECTION("events can be scheduled before an aborted later timeout") {
+    sim.run();
+    auto start = sim.now();
+    std::vector<std::pair<typename TestType::time_type, int>> log;
+    auto record = [&](int id) {
+      return [&log, &sim, id](const auto &) {
+        log.emplace_back(sim.now(), id);
+      };
+    };
+
+    sim.timeout(10).abort();
+    sim.timeout(5).add_callback(record(1));
+    sim.timeout(12).add_callback(record(2));
+    sim.timeout(7).add_callback(record(3));
+    sim.run();
+
+    std::vector<std::pair<typename TestType::time_type, int>> expected = {
+        {start + 5, 1}, {start + 7, 3}, {start + 12, 2}};
+    REQUIRE(log == expected);
+  }
+
+  SECTION("events can be scheduled at the time of a popped aborted timeout") {
+    sim.run();
+    auto start = sim.now();
+    std::vector<std::pair<typename TestType::time_type, int>> log;
+    auto record = [&](int id) {
+      return [&log, &sim, id](const auto &) {
+        log.emplace_back(sim.now(), id);
+      };
+    };
+
+    auto first = sim.timeout(10);
+    first.add_callback(record(1));
+    auto second = sim.timeout(10);
+    second.add_callback(record(2));
+    sim.timeout(5).add_callback([&](const auto &) { first.abort(); });
+    sim.timeout(6).add_callback([&](const auto &) {
+      sim.timeout(4).add_callback(record(3));
+      sim.timeout(4).add_callback(record(4));
+    });
+    sim.run();
+
+    std::vector<std::pair<typename TestType::time_type, int>> expected = {
+        {start + 10, 2}, {start + 10, 3}, {start + 10, 4}};
+    REQUIRE(log == expected);
+  }
+}
+
+simcpp20::event<>
+interruptible_worker(simcpp20::simulation<> &sim, double work_time,
+                     std::vector<std::pair<double, int>> &log) {
+  auto work = sim.timeout(work_time);
+  bool interrupted = false;
+  try {
+    co_await work;
+  } catch (const simcpp20::interrupted &e) {
+    log.emplace_back(sim.now(), std::any_cast<int>(e.cause()));
+    interrupted = true;
+  }
+
+  if (interrupted) {
+    REQUIRE(work.pending());
+    co_await sim.timeout(1);
+  }
+
+  log.emplace_back(sim.now(), 0);
+}
+
+simcpp20::event<>
+interrupting_waiter(simcpp20::simulation<> &sim, simcpp20::event<> ev,
+                    const simcpp20::event<> &other,
+                    std::vector<std::pair<double, int>> &log) {
+  co_await ev;
+  log.emplace_back(sim.now(), 1);
+  other.interrupt(2);
+}
+
+simcpp20::event<> interrupted_waiter(simcpp20::simulation<> &sim,
+                                     simcpp20::event<> ev,
+                                     std::vector<std::pair<double, int>> &log) {
+  co_await ev;
+  log.emplace_back(sim.now(), 2);
+  try {
+    co_await sim.timeout(5);
+  } catch (const simcpp20::interrupted &e) {
+    log.emplace_back(sim.now(), -std::any_cast<int>(e.cause()));
+  }
+}
+
+TEST_CASE("processes can be interrupted") {
+  simcpp20::simulation<> sim;
+  std::vector<std::pair<double, int>> log;
+
+  SECTION("an interrupt is thrown into the awaiting process") {
+    auto proc = interruptible_worker(sim, 5, log);
+    sim.timeout(2).add_callback([proc](const auto &) { proc.interrupt(1); });
+    sim.run();
+
+    std::vector<std::pair<double, int>> expected = {{2, 1}, {3, 0}};
+    REQUIRE(log == expected);
+    REQUIRE(proc.processed());
+  }
+
+  SECTION("an interrupt before the process waits is thrown at its wait") {
+    auto proc = interruptible_worker(sim, 5, log);
+    proc.interrupt(2);
+    sim.run();
+
+    std::vector<std::pair<double, int>> expected = {{0, 2}, {1, 0}};
+    REQUIRE(log == expected);
+  }
+
+  SECTION("interrupting a finished process does nothing") {
+    auto proc = interruptible_worker(sim, 5, log);
+    sim.run();
+    proc.interrupt(3);
+    sim.run();
+
+    std::vector<std::pair<double, int>> expected = {{5, 0}};
+    REQUIRE(log == expected);
+  }
+
+  SECTION("a process resumed by an event is interrupted at its next wait") {
+    auto ev = sim.timeout(1);
+    auto other = sim.event();
+    interrupting_waiter(sim, ev, other, log);
+    other = interrupted_waiter(sim, ev, log);
+    sim.run();
+
+    std::vector<std::pair<double, int>> expected = {{1, 1}, {1, 2}, {1, -2}};
+    REQUIRE(log == expected);
+    REQUIRE(other.processed());
+  }
+}
+
+simcpp20::event<> forever_waiter(simcpp20::simulation<> &,
+                                 simcpp20::event<> ev) {
+  // Keep the frame larger than the blocks of the pool, so that it is
+  // allocated on the heap, where sanitizers check accesses after it is freed.
+  std::array<char, 2048> padding = {};
+  co_await ev;
+  REQUIRE(padding[0] == 0);
+}
+
+TEST_CASE("a simulation can be destroyed while processes are suspended") {
+  std::vector<std::pair<double, int>> log;
+  {
+    simcpp20::simulation<> sim;
+    {
+      // Only the frames of the processes refer to the event.
+      auto ev = sim.event();
+      forever_waiter(sim, ev);
+      forever_waiter(sim, ev);
+    }
+
+    auto ev = sim.timeout(1);
+    auto other = sim.event();
+    interrupting_waiter(sim, ev, other, log);
+    other = interrupted_waiter(sim, ev, log);
+    sim.run_until(0.5);
+  }
+
+  REQUIRE(log.empty());
+}
+
+simcpp20::event<> interruptible_user(simcpp20::simulation<> &sim,
+                                     simcpp20::resource<> &res, int id,
+                                     std::vector<int> &log) {
+  try {
+    co_await res.request();
+  } catch (const simcpp20::interrupted &) {
+    log.push_back(-id);
+    co_return;
+  }
+
+  log.push_back(id);
+  co_await sim.timeout(1);
+  res.release();
+}
+
+TEST_CASE("interrupting a process removes its waiting resource request") {
+  simcpp20::simulation<> sim;
+  simcpp20::resource<> res{sim, 1};
+  std::vector<int> log;
+
+  interruptible_user(sim, res, 1, log);
+  auto second = interruptible_user(sim, res, 2, log);
+  interruptible_user(sim, res, 3, log);
+
+  sim.run_until(0.5);
+  REQUIRE(res.n_waiting() == 2);
+  second.interrupt();
+  REQUIRE(res.n_waiting() == 1);
+  sim.run();
+
+  REQUIRE(log == std::vector<int>{1, -2, 3});
+  REQUIRE(res.available() == 1);
+}
+
+simcpp20::event<> granted_user(simcpp20::simulation<> &sim,
+                               simcpp20::resource<> &res,
+                               std::vector<int> &log) {
+  bool holding = false;
+  try {
+    co_await res.request();
+    holding = true;
+    log.push_back(1);
+    co_await sim.timeout(5);
+    log.push_back(2);
+  } catch (const simcpp20::interrupted &) {
+    log.push_back(-1);
+  }
+
+  if (holding) {
+    res.release();
+  }
+}
+
+TEST_CASE("an interrupt after a grant is thrown at the next wait") {
+  simcpp20::simulation<> sim;
+  simcpp20::resource<> res{sim, 1};
+  std::vector<int> log;
+
+  holding_user(sim, res);
+  auto user = granted_user(sim, res, log);
+  sim.timeout(1).add_callback([&](const auto &) {
+    res.release();
+    user.interrupt();
+  });
+  sim.run();
+
+  REQUIRE(log == std::vector<int>{1, -1});
+  REQUIRE(res.available() == 1);
+}
+
+simcpp20::event<> ticker_proc(simcpp20::simulation<> &sim,
+                              simcpp20::timer<> &ticker, double work_time,
+                              std::vector<double> &log) {
+  for (int i = 0; i < 4; ++i) {
+    co_await ticker;
+    log.push_back(sim.now());
+    co_await sim.timeout(work_time);
+  }
+}
+
+simcpp20::event<> own_ticker_proc(simcpp20::simulation<> &sim) {
+  // Keep the frame larger than the blocks of the pool, so that it is
+  // allocated on the heap, where sanitizers check accesses after it is freed.
+  std::array<char, 2048> padding = {};
+  auto ticker = sim.periodic(1);
+  while (true) {
+    co_await ticker;
+    REQUIRE(padding[0] == 0);
+  }
+}
+
+TEST_CASE("timers tick periodically and skip missed ticks") {
+  simcpp20::simulation<> sim;
+  std::vector<double> log;
+
+  SECTION("processes are resumed at each tick") {
+    auto ticker = sim.periodic(2);
+    ticker_proc(sim, ticker, 0, log);
+    ticker_proc(sim, ticker, 1, log);
+    sim.run();
+
+    REQUIRE(log == std::vector<double>{2, 2, 4, 4, 6, 6, 8, 8});
+    REQUIRE(ticker.period() == 2);
+  }
+
+  SECTION("ticks during which no process waits are skipped") {
+    auto ticker = sim.periodic(2);
+    ticker_proc(sim, ticker, 3, log);
+    sim.run();
+
+    REQUIRE(log == std::vector<double>{2, 6, 10, 14});
+  }
+
+  SECTION("a timer keeps one queue entry") {
+    auto ticker = sim.periodic(1);
+    ticker_proc(sim, ticker, 0, log);
+    sim.run_until(2.5);
+
+    REQUIRE(sim.size() == 1);
+    REQUIRE(ticker.next_time() == 3);
+  }
+
+  SECTION("destroying or replacing a timer removes its pending tick") {
+    {
+      auto ticker = sim.periodic(2);
+      REQUIRE(sim.size() == 1);
+    }
+    REQUIRE(sim.size() == 0);
+
+    auto ticker = sim.periodic(2);
+    auto moved = std::move(ticker);
+    ticker = sim.periodic(5);
+    moved = sim.periodic(3);
+    REQUIRE(sim.size() == 2);
+
+    sim.step();
+    REQUIRE(sim.now() == 3);
+    REQUIRE(sim.size() == 1);
+  }
+
+  SECTION("a process can be destroyed while waiting for its own timer") {
+    simcpp20::simulation<> other;
+    own_ticker_proc(other);
+    other.run_until(1.5);
+    REQUIRE(other.size() == 1);
+  }
+}
+
+simcpp20::event<> logging_child(simcpp20::simulation<> &sim, int id,
+                                std::vector<int> &log) {
+  co_await sim.timeout(1);
+  log.push_back(id);
+}
+
+simcpp20::event<> logging_parent(simcpp20::simulation<> &sim, int id,
+                                 std::vector<int> &log) {
+  co_await logging_child(sim, -id, log);
+  log.push_back(id);
+}
+
+simcpp20::event<> logging_awaiter(simcpp20::simulation<> &,
+                                  simcpp20::event<> ev, int id,
+                                  std::vector<int> &log) {
+  co_await ev;
+  log.push_back(id);
+}
+
+simcpp20::value_event<int> nested_child(simcpp20::simulation<> &sim,
+                                        int depth) {
+  if (depth == 0) {
+    co_await sim.timeout(1);
+    co_return 0;
+  }
+
+  co_return 1 + co_await nested_child(sim, depth - 1);
+}
+
+TEST_CASE("a finishing child process resumes its parent directly") {
+  simcpp20::simulation<> sim;
+  std::vector<int> log;
+
+  SECTION("the parent resumes before other events at the same time") {
+    logging_parent(sim, 1, log);
+    // Start the parent and its child.
+    sim.step();
+    sim.step();
+    logging_child(sim, 2, log);
+    sim.run();
+
+    REQUIRE(log == std::vector<int>{-1, 1, 2});
+  }
+
+  SECTION("events awaited by multiple processes keep the queue round trip") {
+    auto parent = logging_parent(sim, 1, log);
+    // Start the parent and its child.
+    sim.step();
+    sim.step();
+    logging_child(sim, 2, log);
+    for (int id : {3, 4}) {
+      logging_awaiter(sim, parent, id, log);
+    }
+    sim.run();
+
+    REQUIRE(log == std::vector<int>{-1, 1, 2, 3, 4});
+  }
+
+  SECTION("deeply nested children finish without a queue round trip") {
+    auto result = nested_child(sim, 10'000);
+
+    auto n_steps = 0;
+    while (!sim.empty()) {
+      sim.step();
+      ++n_steps;
+    }
+
+    // 10001 starts, the timeout and the event of the outermost process.
+    REQUIRE(result.value() == 10'000);
+    REQUIRE(n_steps == 10'003);
+    REQUIRE(sim.now() == 1);
+  }
+}
+
+TEST_CASE("memory reports count live events, frames and queue entries") {
+  simcpp20::simulation<> sim;
+  auto before = sim.memory();
+  REQUIRE(before.events_.n_blocks_ == 0);
+  REQUIRE(before.n_processes() == 0);
+
+  std::vector<simcpp20::event<>> timeouts;
+  for (int i = 1; i <= 10; ++i) {
+    timeouts.push_back(sim.timeout(i));
+  }
+  std::vector<double> log;
+  auto ticker = sim.periodic(1);
+  ticker_proc(sim, ticker, 0, log);
+
+  auto report = sim.memory();
+  REQUIRE(report.events_.n_blocks_ == 12);
+  REQUIRE(report.frames_.n_blocks_ == 1);
+  REQUIRE(report.n_scheduled_ == 11);
+  REQUIRE(report.n_immediate_ == 1);
+  REQUIRE(report.scheduled_bytes() > 0);
+  REQUIRE(report.pool_bytes_ >= report.events_.bytes_ +
+                                    report.frames_.bytes_ +
+                                    report.immediate_.bytes_);
+
+  timeouts[0].abort();
+  auto aborted = sim.memory();
+  REQUIRE(aborted.n_scheduled_ - aborted.n_discarded_ == 10);
+
+  sim.run();
+  timeouts.clear();
+
+  auto after = sim.memory();
+  REQUIRE(after.events_.n_blocks_ == 1);
+  REQUIRE(after.events_.peak_bytes_ >= report.events_.peak_bytes_);
+  REQUIRE(after.n_processes() == 0);
+  REQUIRE(after.n_scheduled_ == 0);
+  REQUIRE(after.peak_scheduled_ == 11);
+}
+
+TEST_CASE("memory reports count waiter lists and large callbacks") {
+  simcpp20::simulation<> sim;
+  auto ev = sim.timeout(1);
+  std::array<bool, 100> finished{};
+  for (auto &f : finished) {
+    awaiter(sim, ev, 1, f);
+  }
+
+  int sum = 0;
+  std::array<int, 16> values{};
+  values.back() = 42;
+  ev.add_callback([&sum, values](const auto &) { sum += values.back(); });
+
+  auto before = sim.memory();
+  REQUIRE(before.waiters_.n_blocks_ == 0);
+  REQUIRE(before.callbacks_.n_blocks_ == 1);
+  REQUIRE(before.callbacks_.bytes_ >= sizeof(values));
+
+  sim.run_until(0.5);
+  auto waiting = sim.memory();
+  REQUIRE(waiting.waiters_.n_blocks_ == 1);
+  REQUIRE(waiting.waiters_.bytes_ >= finished.size() * sizeof(void *));
+  REQUIRE(waiting.callbacks_ == before.callbacks_);
+
+  sim.run();
+  REQUIRE(sum == 42);
+  REQUIRE(finished.back());
+
+  auto after = sim.memory();
+  REQUIRE(after.waiters_.n_blocks_ == 0);
+  REQUIRE(after.waiters_.bytes_ == 0);
+  REQUIRE(after.waiters_.peak_bytes_ >= waiting.waiters_.bytes_);
+  REQUIRE(after.callbacks_.n_blocks_ == 0);
+  REQUIRE(after.callbacks_.bytes_ == 0);
+}
+
+TEST_CASE("run_for stops after a number of steps or a wall-clock budget") {
+  simcpp20::simulation<> sim;
+  for (int i = 0; i < 1000; ++i) {
+    sim.timeout(i);
+  }
+
+  REQUIRE(sim.run_for(10) == 10);
+  REQUIRE(sim.size() == 990);
+
+  // The clock is read after each batch, so a zero budget runs one batch.
+  REQUIRE(sim.run_for(std::chrono::seconds{0}, 100) == 100);
+  REQUIRE(sim.size() == 890);
+
+  REQUIRE(sim.run_for(std::chrono::hours{1}) == 890);
+  REQUIRE(sim.empty());
+  REQUIRE(sim.run_for(10) == 0);
+}
+
+TEST_CASE("realtime processes events at the corresponding wall-clock time") {
+  using namespace std::chrono_literals;
+
+  simcpp20::simulation<> sim;
+  std::vector<double> log;
+  auto ticker = sim.periodic(1);
+  ticker_proc(sim, ticker, 0, log);
+
+  simcpp20::realtime<> rt{sim, 0.002};
+  auto start = std::chrono::steady_clock::now();
+  rt.run_until(5.5);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  REQUIRE(log == std::vector<double>{1, 2, 3, 4});
+  REQUIRE(sim.now() == 5.5);
+  REQUIRE(elapsed >= 11ms);
+  REQUIRE(rt.deadline(5.5) - start <= 11ms);
+  REQUIRE(rt.lag() >= 0ns);
+  REQUIRE(rt.max_lag() >= rt.lag());
+}
+
+TEST_CASE("monitors summarize samples in fixed memory and can be merged") {
+  simcpp20::tally all;
+  simcpp20::tally even;
+  simcpp20::tally odd;
+  simcpp20::quantile_histogram hist;
+  simcpp20::quantile_histogram even_hist;
+  simcpp20::quantile_histogram odd_hist;
+  for (int i = 1; i <= 10000; ++i) {
+    all.add(i);
+    hist.add(i);
+    (i % 2 == 0 ? even : odd).add(i);
+    (i % 2 == 0 ? even_hist : odd_hist).add(i);
+  }
+
+  REQUIRE(all.count() == 10000);
+  REQUIRE(all.mean() == 5000.5);
+  REQUIRE(std::abs(all.variance() - 10000. * 10001 / 12) < 1e-3);
+  REQUIRE(all.min() == 1);
+  REQUIRE(all.max() == 10000);
+
+  even.merge(odd);
+  REQUIRE(even.count() == all.count());
+  REQUIRE(std::abs(even.mean() - all.mean()) < 1e-9);
+  REQUIRE(std::abs(even.variance() - all.variance()) < 1e-3);
+
+  even_hist.merge(odd_hist);
+  for (double q : {0.01, 0.25, 0.5, 0.9, 0.99}) {
+    auto exact = q * 10000;
+    REQUIRE(std::abs(hist.quantile(q) - exact) <= exact / 32);
+    REQUIRE(even_hist.quantile(q) == hist.quantile(q));
+  }
+  REQUIRE(hist.quantile(0) == 1);
+  REQUIRE(hist.quantile(1) == 10000);
+
+  simcpp20::time_weighted<> level;
+  level.set(0, 2);
+  level.add(1, 2);
+  level.set(3, 0);
+  REQUIRE(level.mean() == 10. / 3);
+  REQUIRE(level.mean(5) == 2);
+  REQUIRE(level.max() == 4);
+
+  simcpp20::counter n;
+  simcpp20::counter m;
+  n.add();
+  m.add(2);
+  n.merge(m);
+  REQUIRE(n.value() == 3);
+}
+
+TEST_CASE("resource monitors record units in use and waiting requests") {
+  auto model = [](std::size_t) {
+    simcpp20::simulation<> sim;
+    simcpp20::resource<> res{sim, 2};
+    simcpp20::resource_monitor<> levels;
+    res.monitor(&levels);
+
+    std::vector<std::pair<double, int>> log;
+    for (int id = 1; id <= 5; ++id) {
+      resource_user(sim, res, id, id == 4 ? 1 : 10, log);
+    }
+
+    sim.run();
+    levels.advance(sim.now());
+    return levels;
+  };
+
+  auto levels = model(0);
+  REQUIRE(levels.in_use.duration() == 4);
+  REQUIRE(levels.utilization(2) == 1);
+  REQUIRE(levels.queue_length.mean() == 1.25);
+  REQUIRE(levels.queue_length.max() == 3);
+  REQUIRE(levels.in_use.level() == 0);
+
+  auto merged = simcpp20::run_replications(
+      4, model, simcpp20::resource_monitor<>{}, [](auto all, const auto &one) {
+        all.merge(one);
+        return all;
+      });
+  REQUIRE(merged.in_use.duration() == 16);
+  REQUIRE(merged.queue_length.mean() == 1.25);
+}
+
+TEST_CASE("philox matches the known answers of Philox4x32-10") {
+  using block = simcpp20::philox::block_type;
+  REQUIRE(simcpp20::philox::apply({0, 0, 0, 0}, {0, 0}) ==
+          block{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+  REQUIRE(simcpp20::philox::apply(
+              {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+              {0xa4093822, 0x299f31d0}) ==
+          block{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+
+  simcpp20::philox a{42, 7};
+  simcpp20::philox b{42, 7};
+  std::vector<std::uint64_t> values(11);
+  a();
+  a.generate(values.data(), values.size());
+  b.discard(1);
+  for (auto value : values) {
+    REQUIRE(b() == value);
+  }
+  REQUIRE(a() == b());
+}
+
+TEST_CASE("random streams do not depend on the order of draws") {
+  simcpp20::random_stream root{1234};
+  auto first = root.substream(1).substream(2);
+  auto second = root.substream(1).substream(2);
+  auto other = root.substream(2).substream(1);
+
+  // Drawing other kinds of variates does not change the exponentials.
+  for (int i = 0; i < 100; ++i) {
+    second.normal();
+    second.uniform();
+  }
+
+  double sum = 0;
+  bool differs = false;
+  for (int i = 0; i < 10000; ++i) {
+    auto value = first.exponential(0.5);
+    REQUIRE(second.exponential(0.5) == value);
+    differs = differs || other.exponential(0.5) != value;
+    sum += value;
+  }
+  REQUIRE(differs);
+  REQUIRE(std::abs(sum / 10000 - 2) < 0.1);
+
+  simcpp20::tally uniforms;
+  simcpp20::tally normals;
+  for (int i = 0; i < 10000; ++i) {
+    uniforms.add(first.uniform(1, 3));
+    normals.add(first.normal(5, 2));
+  }
+  REQUIRE(uniforms.min() >= 1);
+  REQUIRE(uniforms.max() < 3);
+  REQUIRE(std::abs(uniforms.mean() - 2) < 0.05);
+  REQUIRE(std::abs(normals.mean() - 5) < 0.1);
+  REQUIRE(std::abs(normals.variance() - 4) < 0.2);
+
+  std::uniform_int_distribution<int> dist{1, 6};
+  auto roll = dist(first.engine());
+  REQUIRE(roll >= 1);
+  REQUIRE(roll <= 6);
+}
+
+simcpp20::event<>
+store_producer(simcpp20::simulation<> &sim,
+               simcpp20::store<std::unique_ptr<int>> &store, int n,
+               std::vector<std::pair<double, int>> &log) {
+  for (int i = 0; i < n; ++i) {
+    co_await store.put(std::make_unique<int>(i));
+    log.emplace_back(sim.now(), i);
+  }
+}
+
+simcpp20::event<>
+store_consumer(simcpp20::simulation<> &sim,
+               simcpp20::store<std::unique_ptr<int>> &store, int n,
+               std::vector<std::pair<double, int>> &log) {
+  for (int i = 0; i < n; ++i) {
+    co_await sim.timeout(1);
+    auto item = co_await store.get();
+    log.emplace_back(sim.now(), -*item);
+  }
+}
+
+TEST_CASE("store moves items between processes and bounds its size") {
+  simcpp20::simulation<> sim;
+  simcpp20::store<std::unique_ptr<int>> store{sim, 2};
+  std::vector<std::pair<double, int>> log;
+  store_producer(sim, store, 4, log);
+  store_consumer(sim, store, 4, log);
+
+  sim.run_until(0.5);
+  REQUIRE(store.size() == 2);
+  REQUIRE(store.n_putters() == 1);
+
+  sim.run();
+  std::vector<std::pair<double, int>> expected = {
+      {0, 0}, {0, 1}, {1, -0}, {1, 2}, {2, -1}, {2, 3}, {3, -2}, {4, -3}};
+  REQUIRE(log == expected);
+  REQUIRE(store.size() == 0);
+}
+
+simcpp20::event<> store_getter(simcpp20::simulation<> &,
+                               simcpp20::store<int> &store, int id,
+                               std::vector<std::pair<int, int>> &log) {
+  log.emplace_back(id, co_await store.get());
+}
+
+simcpp20::event<> even_getter(simcpp20::simulation<> &,
+                              simcpp20::store<int> &store, int id,
+                              std::vector<std::pair<int, int>> &log) {
+  log.emplace_back(id, co_await store.get([](int i) { return i % 2 == 0; }));
+}
+
+TEST_CASE("store hands items to waiting gets in order of their filters") {
+  simcpp20::simulation<> sim;
+  simcpp20::store<int> store{sim};
+  std::vector<std::pair<int, int>> log;
+
+  even_getter(sim, store, 0, log);
+  for (int id = 1; id <= 1000; ++id) {
+    store_getter(sim, store, id, log);
+  }
+  sim.run();
+  REQUIRE(store.n_getters() == 1001);
+
+  for (int i = 1; i <= 1000; ++i) {
+    store.put(i);
+  }
+  store.put(1002);
+  store.put(1003);
+  sim.run();
+
+  REQUIRE(log.size() == 1001);
+  REQUIRE(log[0] == std::pair{1, 1});
+  REQUIRE(log[1] == std::pair{0, 2});
+  REQUIRE(log[2] == std::pair{2, 3});
+  REQUIRE(log.back() == std::pair{1000, 1002});
+  REQUIRE(store.size() == 1);
+  REQUIRE(store.n_getters() == 0);
+
+  log.clear();
+  store.put(5);
+  even_getter(sim, store, 0, log);
+  sim.run();
+  REQUIRE(store.n_getters() == 1);
+
+  auto waiting = store_getter(sim, store, 1, log);
+  sim.run();
+  REQUIRE(log == std::vector<std::pair<int, int>>{{1, 1003}});
+  REQUIRE(store.size() == 1);
+
+  simcpp20::priority_store<int> prio{sim};
+  for (int i : {5, 1, 4, 2, 3}) {
+    prio.put(i);
+  }
+  std::vector<int> taken;
+  auto take = [&](auto get) {
+    REQUIRE(get.await_ready());
+    taken.push_back(get.await_resume());
+  };
+  take(prio.get());
+  take(prio.get([](int i) { return i > 2; }));
+  take(prio.get());
+  REQUIRE(taken == std::vector<int>{1, 3, 2});
+  REQUIRE(prio.size() == 2);
+}
+
+simcpp20::event<> interruptible_getter(simcpp20::simulation<> &,
+                                       simcpp20::store<int> &store, int id,
+                                       std::vector<std::pair<int, int>> &log) {
+  try {
+    log.emplace_back(id, co_await store.get());
+  } catch (const simcpp20::interrupted &) {
+    log.emplace_back(id, -1);
+  }
+}
+
+TEST_CASE("interrupting a process removes its waiting store get") {
+  simcpp20::simulation<> sim;
+  simcpp20::store<int> store{sim};
+  std::vector<std::pair<int, int>> log;
+
+  auto first = interruptible_getter(sim, store, 1, log);
+  store_getter(sim, store, 2, log);
+  sim.run();
+  REQUIRE(store.n_getters() == 2);
+
+  first.interrupt();
+  sim.run();
+  REQUIRE(store.n_getters() == 1);
+
+  store.put(7);
+  sim.run();
+  REQUIRE(log == std::vector<std::pair<int, int>>{{1, -1}, {2, 7}});
+}
+
+TEST_CASE("an interrupt after an item is delivered does not lose the item") {
+  simcpp20::simulation<> sim;
+  simcpp20::store<int> store{sim};
+  std::vector<std::pair<int, int>> log;
+
+  auto getter = interruptible_getter(sim, store, 1, log);
+  sim.run();
+  REQUIRE(store.n_getters() == 1);
+
+  store.put(7);
+  getter.interrupt();
+  sim.run();
+
+  REQUIRE(log == std::vector<std::pair<int, int>>{{1, 7}});
+  REQUIRE(store.size() == 0);
+}
+
+simcpp20::event<> patient_getter(simcpp20::simulation<> &sim,
+                                 simcpp20::store<int> &store, double patience,
+                                 std::vector<std::pair<double, int>> &log) {
+  auto get = store.get();
+  auto item = co_await get.wait_for(patience);
+  log.emplace_back(sim.now(), item ? *item : -1);
+}
+
+simcpp20::event<> patient_putter(simcpp20::simulation<> &sim,
+                                 simcpp20::store<int> &store, int value,
+                                 double patience,
+                                 std::vector<std::pair<double, int>> &log) {
+  auto put = store.put(value);
+  auto done = co_await put.wait_for(patience);
+  log.emplace_back(sim.now(), done ? value : -value);
+}
+
+TEST_CASE("store puts and gets can wait with a timeout") {
+  simcpp20::simulation<> sim;
+  std::vector<std::pair<double, int>> log;
+
+  SECTION("a get stops waiting when its timeout passes") {
+    simcpp20::store<int> store{sim};
+    patient_getter(sim, store, 2, log);
+    patient_getter(sim, store, 5, log);
+    sim.timeout(3).add_callback([&store](const auto &) { store.put(7); });
+    sim.run();
+
+    REQUIRE(log == std::vector<std::pair<double, int>>{{2, -1}, {3, 7}});
+    REQUIRE(sim.now() == 3);
+    REQUIRE(store.n_getters() == 0);
+
+    store.put(8);
+    REQUIRE(store.size() == 1);
+  }
+
+  SECTION("a get taking an item right away does not wait") {
+    simcpp20::store<int> store{sim};
+    store.put(4);
+    patient_getter(sim, store, 2, log);
+    sim.run();
+
+    REQUIRE(log == std::vector<std::pair<double, int>>{{0, 4}});
+    REQUIRE(sim.now() == 0);
+  }
+
+  SECTION("a put stops waiting when its timeout passes") {
+    simcpp20::store<int> store{sim, 1};
+    store.put(1);
+    patient_putter(sim, store, 2, 2, log);
+    patient_putter(sim, store, 3, 5, log);
+    sim.timeout(3).add_callback([&store](const auto &) {
+      auto get = store.get();
+      REQUIRE(get.await_ready());
+      REQUIRE(get.await_resume() == 1);
+    });
+    sim.run();
+
+    REQUIRE(log == std::vector<std::pair<double, int>>{{2, -2}, {3, 3}});
+    REQUIRE(sim.now() == 3);
+    REQUIRE(store.n_putters() == 0);
+    REQUIRE(store.size() == 1);
+  }
+
+  SECTION("a store can be destroyed while a get waits with a timeout") {
+    auto store = std::make_unique<simcpp20::store<int>>(sim);
+    patient_getter(sim, *store, 2, log);
+    sim.run_until(1);
+    REQUIRE(store->n_getters() == 1);
+
+    store.reset();
+    sim.run();
+    REQUIRE(log.empty());
+  }
+}
+
+simcpp20::event<> injected_receiver(simcpp20::simulation<> &sim,
+                                    simcpp20::injector<int> &inj, int n,
+                                    std::vector<std::pair<double, int>> &log) {
+  for (int i = 0; i < n; ++i) {
+    auto value = co_await inj.receive();
+    log.emplace_back(sim.now(), value);
+  }
+}
+
+TEST_CASE("injected messages are received at their timestamps") {
+  simcpp20::simulation<> sim;
+  simcpp20::injector<int> inj{sim};
+  std::vector<std::pair<double, int>> log;
+  injected_receiver(sim, inj, 4, log);
+
+  inj.post(3, 30);
+  inj.post(1, 10);
+  inj.post(1, 11);
+  sim.run_until(2);
+  REQUIRE(log == std::vector<std::pair<double, int>>{{1, 10}, {1, 11}});
+
+  // Messages whose timestamps passed and messages without a timestamp are
+  // received at the current simulation time.
+  inj.post(1, 12);
+  sim.run();
+  std::vector<std::pair<double, int>> expected = {
+      {1, 10}, {1, 11}, {2, 12}, {3, 30}};
+  REQUIRE(log == expected);
+}
+
+simcpp20::event<> injection_waiter(simcpp20::simulation<> &sim,
+                                   const std::vector<int> &received,
+                                   std::size_t n) {
+  while (received.size() < n) {
+    co_await sim.timeout(1);
+  }
+}
+
+simcpp20::event<> injection_collector(simcpp20::simulation<> &,
+                                      simcpp20::injector<int> &inj,
+                                      std::vector<int> &received,
+                                      std::size_t n) {
+  while (received.size() < n) {
+    received.push_back(co_await inj.receive());
+  }
+}
+
+TEST_CASE("messages can be injected from other threads while running") {
+  simcpp20::simulation<> sim;
+  simcpp20::injector<int> inj{sim};
+  int n_threads = 4;
+  int n_per_thread = 1000;
+  auto n = static_cast<std::size_t>(n_threads * n_per_thread);
+  std::vector<int> received;
+  injection_waiter(sim, received, n);
+  injection_collector(sim, inj, received, n);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&inj, t, n_per_thread] {
+      for (int i = 0; i < n_per_thread; ++i) {
+        inj.post(t * n_per_thread + i);
+      }
+    });
+  }
+
+  sim.run();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  REQUIRE(received.size() == n);
+  // Each thread's messages are received in the order they were posted.
+  std::vector<int> last(n_threads, -1);
+  for (auto value : received) {
+    auto t = value / n_per_thread;
+    REQUIRE(value > last[t]);
+    last[t] = value;
+  }
+}
@@ -0,0 +1,197 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+// Inspect trace files written by simcpp20::trace_observer.
+//
+//     trace cat FILE [KIND] [FROM] [TO]  print records, optionally filtered
+//     trace stats FILE                   print the number of records per kind
+//     trace diff A B                     print the first differing record
+
+#include <array>     // std::array
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::int64_t, std::uint64_t
+#include <cstdio>    // std::printf, std::fprintf
+#include <exception> // std::exception
+#include <optional>  // std::optional
+#include <string>    // std::stod, std::string
+
+#include "fschuetz04/simcpp20/trace_reader.hpp"
+
+namespace {
+constexpr std::array<const char *, 6> kind_names = {
+    "schedule", "process", "start", "resume", "end", "abort"};
+
+const char *kind_name(simcpp20::trace_kind kind) {
+  auto i = static_cast<std::size_t>(kind);
+  return i < kind_names.size() ? kind_names[i] : "unknown";
+}
+
+std::optional<simcpp20::trace_kind> parse_kind(const std::string &name) {
+  for (std::size_t i = 0; i < kind_names.size(); ++i) {
+    if (name == kind_names[i]) {
+      return static_cast<simcpp20::trace_kind>(i);
+    }
+  }
+
+  return std::nullopt;
+}
+
+template <typename Time>
+void print(std::uint64_t i, const simcpp20::trace_record<Time> &record) {
+  std::printf("%llu %.17g %s %llu %u\n", static_cast<unsigned long long>(i),
+              static_cast<double>(record.time_), kind_name(record.kind_),
+              static_cast<unsigned long long>(record.id_), record.count_);
+}
+
+template <typename Time> int cat(int argc, char **argv) {
+  std::optional<simcpp20::trace_kind> kind;
+  if (argc > 3 && std::string{argv[3]} != "all") {
+    kind = parse_kind(argv[3]);
+    if (!kind) {
+      std::fprintf(stderr, "unknown kind %s\n", argv[3]);
+      return 1;
+    }
+  }
+
+  std::optional<double> from;
+  if (argc > 4) {
+    from = std::stod(argv[4]);
+  }
+
+  std::optional<double> to;
+  if (argc > 5) {
+    to = std::stod(argv[5]);
+  }
+
+  simcpp20::trace_reader<Time> reader{argv[2]};
+  reader.for_each([&](const simcpp20::trace_record<Time> &record) {
+    auto time = static_cast<double>(record.time_);
+    if ((kind && record.kind_ != *kind) || (from && time < *from) ||
+        (to && time > *to)) {
+      return;
+    }
+
+    print(reader.n_read() - 1, record);
+  });
+
+  return 0;
+}
+
+template <typename Time> int stats(char **argv) {
+  std::array<std::uint64_t, kind_names.size()> counts{};
+  std::optional<Time> first;
+  Time last{};
+
+  simcpp20::trace_reader<Time> reader{argv[2]};
+  reader.for_each([&](const simcpp20::trace_record<Time> &record) {
+    auto i = static_cast<std::size_t>(record.kind_);
+    if (i < counts.size()) {
+      ++counts[i];
+    }
+
+    if (record.kind_ != simcpp20::trace_kind::schedule) {
+      if (!first) {
+        first = record.time_;
+      }
+      last = record.time_;
+    }
+  });
+
+  std::printf("records %llu\n", static_cast<unsigned long long>(
+                                    reader.n_read()));
+  for (std::size_t i = 0; i < counts.size(); ++i) {
+    std::printf("%s %llu\n", kind_names[i],
+                static_cast<unsigned long long>(counts[i]));
+  }
+  if (first) {
+    std::printf("time %.17g %.17g\n", static_cast<double>(*first),
+                static_cast<double>(last));
+  }
+
+  return 0;
+}
+
+template <typename Time> int diff(char **argv) {
+  auto index = simcpp20::first_difference<Time>(argv[2], argv[3]);
+  if (!index) {
+    std::printf("traces are equal\n");
+    return 0;
+  }
+
+  std::printf("traces differ at record %llu\n",
+              static_cast<unsigned long long>(*index));
+
+  for (int j = 2; j < 4; ++j) {
+    simcpp20::trace_reader<Time> reader{argv[j]};
+    simcpp20::trace_record<Time> record{};
+    while (reader.next(record) && reader.n_read() <= *index) {
+    }
+
+    std::printf("%s: ", argv[j]);
+    if (reader.n_read() > *index) {
+      print(*index, record);
+    } else {
+      std::printf("end of trace\n");
+    }
+  }
+
+  return 1;
+}
+
+int usage(char **argv) {
+  std::fprintf(stderr, "usage: %s cat FILE [KIND] [FROM] [TO]\n"
+                       "       %s stats FILE\n"
+                       "       %s diff A B\n",
+               argv[0], argv[0], argv[0]);
+  return 2;
+}
+
+template <typename Time> int dispatch(int argc, char **argv) {
+  std::string command = argv[1];
+  if (command == "cat") {
+    return cat<Time>(argc, argv);
+  }
+
+  if (command == "stats") {
+    return stats<Time>(argv);
+  }
+
+  if (command == "diff" && argc > 3) {
+    return diff<Time>(argv);
+  }
+
+  return usage(argv);
+}
+
+template <typename Time> bool matches(const simcpp20::trace_header &header) {
+  return header == simcpp20::trace_header::make<Time>();
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    return usage(argv);
+  }
+
+  try {
+    auto header = simcpp20::read_trace_header(argv[2]);
+    if (matches<double>(header)) {
+      return dispatch<double>(argc, argv);
+    }
+    if (matches<float>(header)) {
+      return dispatch<float>(argc, argv);
+    }
+    if (matches<std::int64_t>(header)) {
+      return dispatch<std::int64_t>(argc, argv);
+    }
+    if (matches<std::uint64_t>(header)) {
+      return dispatch<std::uint64_t>(argc, argv);
+    }
+
+    std::fprintf(stderr, "unsupported time type in %s\n", argv[2]);
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "%s\n", e.what());
+  }
+
+  return 1;
+}